@@ -45,6 +45,10 @@ ttest(recv_reorder)
 ttest(recv_reorder_more)
 ttest(recv_close)
 ttest(recv_special)
+ttest(recv_timestamps)
+ttest(recv_batch)
+ttest(recv_sack)
+ttest(recv_ecn)
 
 ttest(send_connect)
 ttest(send_transmit)
@@ -53,8 +57,29 @@ ttest(send_window)
 ttest(send_ack)
 ttest(send_close)
 ttest(send_extra)
+ttest(send_congestion)
+ttest(send_bbr)
+ttest(send_fast_retx)
+ttest(send_sack)
+ttest(send_rto)
+ttest(send_pacing)
+ttest(send_mss)
+ttest(send_mtu_probe)
+ttest(send_rack_tlp)
+ttest(send_frto)
+ttest(send_ecn)
+ttest(send_notsent_lowat)
+ttest(send_coalescing)
+ttest(send_policy)
+ttest(send_shared_wheel)
 
 ttest(net_interface)
+ttest(timing_wheel)
+ttest(fast_random)
+ttest(stream_mux)
+ttest(tcp_segment)
+ttest(tcp_peer)
+ttest(tcp_over_ip)
 
 ttest(router)
 
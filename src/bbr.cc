@@ -0,0 +1,232 @@
+#include "bbr.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+using namespace std;
+
+uint64_t BBRCongestionControl::bdp( double gain ) const
+{
+  if ( !min_rtt_ms_.has_value() || btl_bw() == 0 ) {
+    return INITIAL_WINDOW_SEGMENTS * mss_; // no model of the path yet
+  }
+  return static_cast<uint64_t>( gain * static_cast<double>( btl_bw() * min_rtt_ms_.value() ) / 1000.0 );
+}
+
+optional<uint64_t> BBRCongestionControl::pacing_rate() const
+{
+  if ( pacing_rate_ > 0 ) {
+    return pacing_rate_;
+  }
+  if ( min_rtt_ms_.has_value() && min_rtt_ms_.value() > 0 ) {
+    return static_cast<uint64_t>( HIGH_GAIN * static_cast<double>( cwnd_ * 1000 / min_rtt_ms_.value() ) );
+  }
+  return {};
+}
+
+void BBRCongestionControl::on_ack( const AckEvent& ack )
+{
+  update_round( ack );
+  update_btl_bw( ack );
+  check_cycle_phase( ack );
+  check_full_pipe( ack );
+  check_drain( ack );
+  update_min_rtt( ack );
+  check_probe_rtt( ack );
+  set_pacing_rate();
+  set_cwnd( ack );
+}
+
+void BBRCongestionControl::on_loss( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+  if ( !recovery_end_round_.has_value() ) {
+    enter_recovery();
+    cwnd_ = max( in_flight, mss_ );
+  }
+}
+
+void BBRCongestionControl::on_rto( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  enter_recovery();
+  cwnd_ = mss_;
+}
+
+void BBRCongestionControl::on_spurious_rto( uint64_t /* now_ms */ )
+{
+  // The path model was never touched, so leaving recovery restores the window
+  recovery_end_round_.reset();
+  cwnd_ = max( cwnd_, prior_cwnd_ );
+}
+
+void BBRCongestionControl::enter_recovery()
+{
+  save_cwnd();
+  recovery_end_round_ = round_count_ + 1;
+}
+
+void BBRCongestionControl::save_cwnd()
+{
+  if ( !recovery_end_round_.has_value() && mode_ != Mode::PROBE_RTT ) {
+    prior_cwnd_ = cwnd_;
+  } else {
+    prior_cwnd_ = max( prior_cwnd_, cwnd_ );
+  }
+}
+
+void BBRCongestionControl::enter_startup()
+{
+  mode_ = Mode::STARTUP;
+  pacing_gain_ = HIGH_GAIN;
+  cwnd_gain_ = HIGH_GAIN;
+}
+
+void BBRCongestionControl::enter_probe_bw( uint64_t now_ms )
+{
+  mode_ = Mode::PROBE_BW;
+  cwnd_gain_ = 2;
+  // Start anywhere in the cycle except the draining phase, so flows don't probe in lockstep
+  cycle_index_ = round_count_ % ( PACING_GAIN_CYCLE.size() - 1 );
+  cycle_index_ += cycle_index_ >= 1 ? 1 : 0;
+  pacing_gain_ = PACING_GAIN_CYCLE.at( cycle_index_ );
+  cycle_stamp_ms_ = now_ms;
+}
+
+void BBRCongestionControl::update_round( const AckEvent& ack )
+{
+  round_start_ = false;
+  if ( ack.rate_sample.has_value() && ack.rate_sample->prior_delivered >= next_round_delivered_ ) {
+    next_round_delivered_ = ack.delivered;
+    round_count_++;
+    round_start_ = true;
+  }
+}
+
+void BBRCongestionControl::update_btl_bw( const AckEvent& ack )
+{
+  if ( !ack.rate_sample.has_value() ) {
+    return;
+  }
+  // An app-limited sample only says the path can do at least this much
+  if ( ack.rate_sample->delivery_rate >= btl_bw() || !ack.rate_sample->app_limited ) {
+    btl_bw_.update( ack.rate_sample->delivery_rate, round_count_ );
+  }
+}
+
+void BBRCongestionControl::check_cycle_phase( const AckEvent& ack )
+{
+  if ( mode_ != Mode::PROBE_BW ) {
+    return;
+  }
+  const bool is_full_length = ack.now_ms - cycle_stamp_ms_ > min_rtt_ms_.value_or( 0 );
+  bool advance = is_full_length;
+  if ( pacing_gain_ > 1 ) {
+    advance = is_full_length && ack.in_flight >= bdp( pacing_gain_ );
+  } else if ( pacing_gain_ < 1 ) {
+    advance = is_full_length || ack.in_flight <= bdp( 1 );
+  }
+  if ( advance ) {
+    cycle_index_ = ( cycle_index_ + 1 ) % PACING_GAIN_CYCLE.size();
+    cycle_stamp_ms_ = ack.now_ms;
+    pacing_gain_ = PACING_GAIN_CYCLE.at( cycle_index_ );
+  }
+}
+
+void BBRCongestionControl::check_full_pipe( const AckEvent& ack )
+{
+  if ( filled_pipe_ || !round_start_ || ack.rate_sample->app_limited ) {
+    return;
+  }
+  if ( btl_bw() >= full_bw_ + full_bw_ / 4 ) { // still growing by at least 25% per round
+    full_bw_ = btl_bw();
+    full_bw_count_ = 0;
+    return;
+  }
+  if ( ++full_bw_count_ >= FULL_BW_ROUNDS ) {
+    filled_pipe_ = true;
+  }
+}
+
+void BBRCongestionControl::check_drain( const AckEvent& ack )
+{
+  if ( mode_ == Mode::STARTUP && filled_pipe_ ) {
+    mode_ = Mode::DRAIN;
+    pacing_gain_ = 1 / HIGH_GAIN;
+    cwnd_gain_ = HIGH_GAIN;
+  }
+  if ( mode_ == Mode::DRAIN && ack.in_flight <= bdp( 1 ) ) {
+    enter_probe_bw( ack.now_ms );
+  }
+}
+
+void BBRCongestionControl::update_min_rtt( const AckEvent& ack )
+{
+  const optional<uint64_t> rtt = ack.rate_sample.has_value() ? ack.rate_sample->rtt_ms : ack.rtt_ms;
+  const bool expired = min_rtt_ms_.has_value() && ack.now_ms > min_rtt_stamp_ms_ + MIN_RTT_FILTER_MS;
+  if ( rtt.has_value() && ( !min_rtt_ms_.has_value() || rtt.value() <= min_rtt_ms_.value() || expired ) ) {
+    min_rtt_ms_ = rtt;
+    min_rtt_stamp_ms_ = ack.now_ms;
+  }
+  if ( expired && mode_ != Mode::PROBE_RTT ) {
+    mode_ = Mode::PROBE_RTT;
+    pacing_gain_ = 1;
+    cwnd_gain_ = 1;
+    save_cwnd();
+    probe_rtt_done_ms_.reset();
+  }
+}
+
+void BBRCongestionControl::check_probe_rtt( const AckEvent& ack )
+{
+  if ( mode_ != Mode::PROBE_RTT ) {
+    return;
+  }
+  if ( !probe_rtt_done_ms_.has_value() && ack.in_flight <= min_pipe_cwnd() ) {
+    // The queue has drained: hold here for PROBE_RTT_DURATION_MS and at least one round trip
+    probe_rtt_done_ms_ = ack.now_ms + PROBE_RTT_DURATION_MS;
+    probe_rtt_round_done_ = false;
+    next_round_delivered_ = ack.delivered;
+  } else if ( probe_rtt_done_ms_.has_value() ) {
+    probe_rtt_round_done_ |= round_start_;
+    if ( probe_rtt_round_done_ && ack.now_ms >= probe_rtt_done_ms_.value() ) {
+      min_rtt_stamp_ms_ = ack.now_ms;
+      cwnd_ = max( cwnd_, prior_cwnd_ );
+      if ( filled_pipe_ ) {
+        enter_probe_bw( ack.now_ms );
+      } else {
+        enter_startup();
+      }
+    }
+  }
+}
+
+void BBRCongestionControl::set_pacing_rate()
+{
+  const auto rate = static_cast<uint64_t>( pacing_gain_ * static_cast<double>( btl_bw() ) );
+  if ( rate > 0 && ( filled_pipe_ || rate > pacing_rate_ ) ) {
+    pacing_rate_ = rate;
+  }
+}
+
+void BBRCongestionControl::set_cwnd( const AckEvent& ack )
+{
+  if ( recovery_end_round_.has_value() && round_count_ <= recovery_end_round_.value() ) {
+    // Packet conservation: send only as much as was just delivered
+    cwnd_ = max( cwnd_, ack.in_flight + ack.acked );
+  } else {
+    if ( recovery_end_round_.has_value() ) {
+      recovery_end_round_.reset();
+      cwnd_ = max( cwnd_, prior_cwnd_ );
+    }
+    const uint64_t target = bdp( cwnd_gain_ ) + 3 * mss_; // allow for delayed and stretched ACKs
+    if ( filled_pipe_ ) {
+      cwnd_ = min( cwnd_ + ack.acked, target );
+    } else if ( cwnd_ < target || ack.delivered < INITIAL_WINDOW_SEGMENTS * mss_ ) {
+      cwnd_ += ack.acked;
+    }
+  }
+  cwnd_ = max( cwnd_, min_pipe_cwnd() );
+  if ( mode_ == Mode::PROBE_RTT ) {
+    cwnd_ = min( cwnd_, min_pipe_cwnd() );
+  }
+}
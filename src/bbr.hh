@@ -0,0 +1,133 @@
+#pragma once
+
+#include "congestion_control.hh"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+
+/*
+ * The maximum of the values seen over a sliding window of "time" (here, round trips).
+ * Kept as a monotonic queue, so update() and get() are amortized O(1).
+ */
+class WindowedMaxFilter
+{
+  uint64_t window_;
+  std::deque<std::pair<uint64_t, uint64_t>> samples_ {}; // (time, value), values decreasing
+
+public:
+  explicit WindowedMaxFilter( uint64_t window ) : window_( window ) {}
+
+  void update( uint64_t value, uint64_t time )
+  {
+    while ( !samples_.empty() && samples_.back().second <= value ) {
+      samples_.pop_back();
+    }
+    samples_.emplace_back( time, value );
+    while ( samples_.front().first + window_ <= time ) {
+      samples_.pop_front();
+    }
+  }
+
+  uint64_t get() const { return samples_.empty() ? 0 : samples_.front().second; }
+};
+
+/*
+ * BBR congestion control (draft-cardwell-iccrg-bbr-congestion-control-00).
+ *
+ * Rather than reacting to loss, BBR builds a model of the path from delivery rate samples: the
+ * bottleneck bandwidth (a windowed max over the last 10 round trips) and the round-trip
+ * propagation delay (a windowed min over the last 10 seconds). It paces at a multiple of the
+ * bandwidth estimate and keeps about one bandwidth-delay product in flight, cycling through:
+ *
+ *   STARTUP:   double the sending rate every round until the bandwidth estimate stops growing
+ *   DRAIN:     drain the queue that STARTUP built at the bottleneck
+ *   PROBE_BW:  cruise at the estimated bandwidth, periodically probing for more (gain 1.25)
+ *              and then draining what the probe queued (gain 0.75)
+ *   PROBE_RTT: if min_rtt hasn't been refreshed in 10 s, shrink the window to 4 segments for
+ *              200 ms so the queue empties and the propagation delay can be measured again
+ *
+ * Random loss does not reduce the window, so a lossy long-haul path can still run near capacity.
+ */
+class BBRCongestionControl : public CongestionControl
+{
+public:
+  enum class Mode
+  {
+    STARTUP,
+    DRAIN,
+    PROBE_BW,
+    PROBE_RTT,
+  };
+
+private:
+  static constexpr double HIGH_GAIN = 2.885; // 2/ln(2), enough to double the delivery rate each round
+  static constexpr std::array<double, 8> PACING_GAIN_CYCLE { 1.25, 0.75, 1, 1, 1, 1, 1, 1 };
+  static constexpr uint64_t BTL_BW_FILTER_ROUNDS = 10;
+  static constexpr uint64_t MIN_RTT_FILTER_MS = 10000;
+  static constexpr uint64_t PROBE_RTT_DURATION_MS = 200;
+  static constexpr uint64_t MIN_PIPE_CWND_SEGMENTS = 4;
+  static constexpr uint64_t FULL_BW_ROUNDS = 3;
+
+  uint64_t cwnd_;
+  Mode mode_ { Mode::STARTUP };
+  double pacing_gain_ { HIGH_GAIN };
+  double cwnd_gain_ { HIGH_GAIN };
+  uint64_t pacing_rate_ {};
+
+  WindowedMaxFilter btl_bw_ { BTL_BW_FILTER_ROUNDS };
+  std::optional<uint64_t> min_rtt_ms_ {};
+  uint64_t min_rtt_stamp_ms_ {};
+
+  uint64_t round_count_ {};
+  uint64_t next_round_delivered_ {};
+  bool round_start_ {};
+
+  bool filled_pipe_ {};
+  uint64_t full_bw_ {};
+  uint64_t full_bw_count_ {};
+
+  size_t cycle_index_ {};
+  uint64_t cycle_stamp_ms_ {};
+
+  std::optional<uint64_t> probe_rtt_done_ms_ {};
+  bool probe_rtt_round_done_ {};
+
+  uint64_t prior_cwnd_ {};
+  std::optional<uint64_t> recovery_end_round_ {}; // Packet conservation until this round ends
+
+  uint64_t bdp( double gain ) const;
+  uint64_t min_pipe_cwnd() const { return MIN_PIPE_CWND_SEGMENTS * mss_; }
+  void save_cwnd();
+  void enter_startup();
+  void enter_probe_bw( uint64_t now_ms );
+  void update_round( const AckEvent& ack );
+  void update_btl_bw( const AckEvent& ack );
+  void check_cycle_phase( const AckEvent& ack );
+  void check_full_pipe( const AckEvent& ack );
+  void check_drain( const AckEvent& ack );
+  void update_min_rtt( const AckEvent& ack );
+  void check_probe_rtt( const AckEvent& ack );
+  void set_pacing_rate();
+  void set_cwnd( const AckEvent& ack );
+  void enter_recovery();
+
+public:
+  explicit BBRCongestionControl( uint64_t mss ) : CongestionControl( mss ), cwnd_( INITIAL_WINDOW_SEGMENTS * mss )
+  {}
+
+  void on_ack( const AckEvent& ack ) override;
+  void on_loss( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_spurious_rto( uint64_t now_ms ) override;
+  void on_ecn( uint64_t /* in_flight */, uint64_t /* now_ms */ ) override {} // BBR v1 doesn't use ECN
+
+  uint64_t cwnd() const override { return cwnd_; }
+  std::optional<uint64_t> pacing_rate() const override;
+
+  Mode mode() const { return mode_; }
+  uint64_t btl_bw() const { return btl_bw_.get(); } // Bottleneck bandwidth estimate, in bytes per second
+  std::optional<uint64_t> min_rtt_ms() const { return min_rtt_ms_; }
+};
@@ -11,25 +11,31 @@ using namespace std;
 
 ByteStream::ByteStream( uint64_t capacity )
   : capacity_( capacity ), available_capacity_( capacity ), error_( false ), closed_( false )
-{
-  buffer_.resize( capacity_ );
-}
+{}
 
-void Writer::push( string data )
+void Writer::push( string_view data )
 {
   uint64_t len = data.length();
   if ( len > available_capacity_ ) {
     len = available_capacity_;
   }
-  if ( capacity_ - wpointer_ < len ) {
-    data.copy( buffer_.data() + wpointer_, capacity_ - wpointer_ );
-    data.copy( buffer_.data(), len - capacity_ + wpointer_, capacity_ - wpointer_ );
-  } else {
-    data.copy( buffer_.data() + wpointer_, len );
+  if ( len == 0 ) {
+    return;
+  }
+  data = data.substr( 0, len );
+  // Append to the last chunk while it has room, even once the Reader has sliced and popped it;
+  // a copy of this stream shares the chunk, but only the first to append gets to use the room
+  if ( chunks_.empty() || !chunks_.back().append_in_place( data ) ) {
+    if ( available_capacity_ == capacity_ ) {
+      chunks_.clear(); // Let go of a fully popped chunk kept for its room
+      front_offset_ = 0;
+    }
+    string chunk;
+    chunk.reserve( max( len, min( MIN_CHUNK_SIZE, available_capacity_ ) ) );
+    chunk.append( data );
+    chunks_.push_back( Buffer { std::move( chunk ) }.slice( 0 ) ); // A slice, so only appends grow it
   }
   pushed_ += len;
-  wpointer_ += len;
-  wpointer_ -= wpointer_ >= capacity_ ? capacity_ : 0;
   available_capacity_ -= len;
 }
 
@@ -61,14 +67,25 @@ uint64_t Writer::bytes_pushed() const
 
 string_view Reader::peek() const
 {
-  static string view;
-  if ( rpointer_ > wpointer_ || ( rpointer_ == wpointer_ && available_capacity_ == 0 ) ) {
-    view.assign( buffer_, rpointer_, capacity_ - rpointer_ );
-    view += buffer_.substr( 0, wpointer_ );
-    return view;
+  if ( chunks_.empty() ) {
+    return {};
+  }
+  return string_view { chunks_.front() }.substr( front_offset_ );
+}
+
+Buffer Reader::peek_buffer( uint64_t len ) const
+{
+  len = min( len, bytes_buffered() );
+  if ( chunks_.empty() || chunks_.front().size() - front_offset_ >= len ) {
+    return chunks_.empty() ? Buffer {} : chunks_.front().slice( front_offset_, len );
+  }
+  string joined;
+  joined.reserve( len );
+  uint64_t offset = front_offset_;
+  for ( auto chunk = chunks_.begin(); joined.size() < len; ++chunk, offset = 0 ) {
+    joined.append( string_view { *chunk }.substr( offset, len - joined.size() ) );
   }
-  string_view v = buffer_;
-  return v.substr( rpointer_, wpointer_ - rpointer_ );
+  return joined;
 }
 
 bool Reader::is_finished() const
@@ -87,10 +104,16 @@ void Reader::pop( uint64_t len )
   if ( len > capacity_ - available_capacity_ ) {
     len = capacity_ - available_capacity_;
   }
-  rpointer_ += len;
   available_capacity_ += len;
-  if ( rpointer_ >= capacity_ ) {
-    rpointer_ -= capacity_;
+  while ( len > 0 ) {
+    const uint64_t from_front = min( len, chunks_.front().size() - front_offset_ );
+    front_offset_ += from_front;
+    len -= from_front;
+    // The last chunk stays, for the next small writes to fill its room
+    if ( front_offset_ == chunks_.front().size() && chunks_.size() > 1 ) {
+      chunks_.pop_front();
+      front_offset_ = 0;
+    }
   }
 }
 
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "buffer.hh"
+
 #include <cstdint>
+#include <deque>
 #include <queue>
 #include <stdexcept>
 #include <string>
@@ -14,9 +17,11 @@ class ByteStream
 protected:
   uint64_t capacity_;
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
-  std::string buffer_ {};
-  uint64_t rpointer_ {};
-  uint64_t wpointer_ {};
+  // Buffered bytes are kept in reference-counted chunks, so the Reader can hand out slices of them
+  // that stay valid after they are popped (until the last slice lets go)
+  static constexpr uint64_t MIN_CHUNK_SIZE = 4096; // Small writes are appended to a chunk this big
+  std::deque<Buffer> chunks_ {};
+  uint64_t front_offset_ {}; // Bytes already popped from the front chunk
   uint64_t pushed_ {};
   uint64_t available_capacity_;
   bool error_;
@@ -36,7 +41,7 @@ public:
 class Writer : public ByteStream
 {
 public:
-  void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
+  void push( std::string_view data ); // Push data to stream, but only as much as available capacity allows.
 
   void close();     // Signal that the stream has reached its ending. Nothing more will be written.
   void set_error(); // Signal that the stream suffered an error.
@@ -52,6 +57,10 @@ public:
   std::string_view peek() const; // Peek at the next bytes in the buffer
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Up to the next `len` bytes as a Buffer: a slice of the stream's own storage, copied only
+  // when the bytes span more than one write
+  Buffer peek_buffer( uint64_t len ) const;
+
   bool is_finished() const; // Is the stream finished (closed and fully popped)?
   bool has_error() const;   // Has the stream had an error?
 
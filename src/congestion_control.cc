@@ -0,0 +1,149 @@
+#include "congestion_control.hh"
+#include "bbr.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+using namespace std;
+
+unique_ptr<CongestionControl> make_congestion_control( CongestionControlAlgorithm algorithm, uint64_t mss )
+{
+  switch ( algorithm ) {
+    case CongestionControlAlgorithm::RENO:
+      return make_unique<RenoCongestionControl>( mss );
+    case CongestionControlAlgorithm::CUBIC:
+      return make_unique<CubicCongestionControl>( mss );
+    case CongestionControlAlgorithm::BBR:
+      return make_unique<BBRCongestionControl>( mss );
+    case CongestionControlAlgorithm::DCTCP:
+      return make_unique<DCTCPCongestionControl>( mss );
+    case CongestionControlAlgorithm::NONE:
+      break;
+  }
+  return nullptr;
+}
+
+void RenoCongestionControl::on_ack( const AckEvent& ack )
+{
+  if ( cwnd_ < ssthresh_ ) { // slow start
+    cwnd_ += min( ack.acked, mss_ );
+    return;
+  }
+  bytes_acked_ += ack.acked; // congestion avoidance: one MSS per cwnd of ACKed data
+  if ( bytes_acked_ >= cwnd_ ) {
+    bytes_acked_ -= cwnd_;
+    cwnd_ += mss_;
+  }
+}
+
+void RenoCongestionControl::on_loss( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  cwnd_ = ssthresh_;
+  bytes_acked_ = 0;
+}
+
+void RenoCongestionControl::on_rto( uint64_t in_flight, uint64_t /* now_ms */ )
+{
+  prior_cwnd_ = cwnd_;
+  prior_ssthresh_ = ssthresh_;
+  ssthresh_ = max( in_flight / 2, 2 * mss_ );
+  cwnd_ = mss_;
+  bytes_acked_ = 0;
+}
+
+void RenoCongestionControl::on_spurious_rto( uint64_t /* now_ms */ )
+{
+  cwnd_ = max( cwnd_, prior_cwnd_ );
+  ssthresh_ = max( ssthresh_, prior_ssthresh_ );
+}
+
+void CubicCongestionControl::reduce()
+{
+  const double cwnd_segments = static_cast<double>( cwnd_ ) / static_cast<double>( mss_ );
+  // Fast convergence: release some bandwidth if the last plateau wasn't reached
+  w_max_ = cwnd_segments < w_max_ ? cwnd_segments * ( 1 + BETA ) / 2 : cwnd_segments;
+  ssthresh_ = max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * BETA ), 2 * mss_ );
+  epoch_start_.reset();
+}
+
+void CubicCongestionControl::on_ack( const AckEvent& ack )
+{
+  if ( cwnd_ < ssthresh_ ) { // slow start
+    cwnd_ += min( ack.acked, mss_ );
+    return;
+  }
+
+  const double mss = static_cast<double>( mss_ );
+  const double cwnd_segments = static_cast<double>( cwnd_ ) / mss;
+  if ( !epoch_start_.has_value() ) {
+    epoch_start_ = ack.now_ms;
+    if ( cwnd_segments < w_max_ ) {
+      k_ = cbrt( ( w_max_ - cwnd_segments ) / C );
+    } else {
+      k_ = 0;
+      w_max_ = cwnd_segments;
+    }
+    w_est_ = cwnd_segments;
+  }
+
+  // Where the cubic curve will be one RTT from now, but never more than 1.5x the current window
+  const double t = static_cast<double>( ack.now_ms - epoch_start_.value() + ack.rtt_ms.value_or( 0 ) ) / 1000.0;
+  const double target = min( w_max_ + C * pow( t - k_, 3 ), 1.5 * cwnd_segments );
+  const double acked_segments = static_cast<double>( ack.acked ) / mss;
+  w_est_ += 3 * ( 1 - BETA ) / ( 1 + BETA ) * acked_segments / cwnd_segments;
+
+  double next = cwnd_segments;
+  if ( target > cwnd_segments ) {
+    next += ( target - cwnd_segments ) / cwnd_segments * acked_segments;
+  }
+  next = max( next, w_est_ );
+  cwnd_ = max( cwnd_, static_cast<uint64_t>( next * mss ) );
+}
+
+void CubicCongestionControl::on_loss( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  reduce();
+  cwnd_ = ssthresh_;
+}
+
+void CubicCongestionControl::on_rto( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  prior_cwnd_ = cwnd_;
+  prior_ssthresh_ = ssthresh_;
+  prior_w_max_ = w_max_;
+  reduce();
+  cwnd_ = mss_;
+}
+
+void CubicCongestionControl::on_spurious_rto( uint64_t /* now_ms */ )
+{
+  cwnd_ = max( cwnd_, prior_cwnd_ );
+  ssthresh_ = max( ssthresh_, prior_ssthresh_ );
+  w_max_ = prior_w_max_;
+  epoch_start_.reset();
+}
+
+void DCTCPCongestionControl::on_ack( const AckEvent& ack )
+{
+  acked_ += ack.acked;
+  marked_ += ack.ece ? ack.acked : 0;
+  if ( ack.delivered >= window_end_ ) {
+    if ( acked_ > 0 ) {
+      alpha_ = ( 1 - G ) * alpha_ + G * static_cast<double>( marked_ ) / static_cast<double>( acked_ );
+    }
+    acked_ = 0;
+    marked_ = 0;
+    window_end_ = ack.delivered + ack.in_flight;
+  }
+  RenoCongestionControl::on_ack( ack );
+}
+
+void DCTCPCongestionControl::on_ecn( uint64_t /* in_flight */, uint64_t /* now_ms */ )
+{
+  cwnd_ = max( static_cast<uint64_t>( static_cast<double>( cwnd_ ) * ( 1 - alpha_ / 2 ) ), 2 * mss_ );
+  ssthresh_ = cwnd_;
+  bytes_acked_ = 0;
+}
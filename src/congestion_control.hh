@@ -0,0 +1,166 @@
+#pragma once
+
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/*
+ * A delivery rate sample (draft-cheng-iccrg-delivery-rate-estimation), taken from the most
+ * recently sent segment that an ACK fully acknowledged.
+ */
+struct DeliveryRateSample
+{
+  uint64_t delivery_rate {};   // Bytes per second delivered over the sampling interval
+  uint64_t rtt_ms {};          // RTT of that segment
+  uint64_t prior_delivered {}; // Sequence numbers delivered when that segment was sent
+  bool app_limited {};         // Was the sender out of data when it sent that segment?
+};
+
+/*
+ * What the TCPSender tells its congestion controller about an ACK that acknowledged new data.
+ * All quantities are in sequence numbers (bytes, plus one each for SYN and FIN).
+ */
+struct AckEvent
+{
+  uint64_t acked {};                                // How many sequence numbers were newly acknowledged
+  uint64_t in_flight {};                            // How many are still outstanding after the ACK
+  uint64_t now_ms {};                               // The sender's clock
+  std::optional<uint64_t> rtt_ms {};                // RTT sample taken from this ACK, if any
+  uint64_t delivered {};                            // Sequence numbers delivered since the connection began
+  std::optional<DeliveryRateSample> rate_sample {}; // Absent if no whole segment was acknowledged
+  bool ece {};                                      // Did the ACK echo congestion experienced (ECN)?
+};
+
+/*
+ * The interface between the TCPSender and a congestion control algorithm.
+ *
+ * The sender reports every ACK of new data, every loss detected while the connection is still
+ * ACK-clocked (e.g. by duplicate ACKs), and every retransmission timeout, along with any timeout
+ * it later finds to have been spurious, so the controller can undo its response. With ECN, it
+ * reports the first ECE of each window of data as well. It never lets more than
+ * min(cwnd(), receive window) sequence numbers be outstanding, and if pacing_rate() has a value,
+ * it spaces transmissions out to that many bytes per second.
+ */
+class CongestionControl
+{
+public:
+  static constexpr uint64_t INITIAL_WINDOW_SEGMENTS = 10; // Initial window of RFC 6928
+
+  explicit CongestionControl( uint64_t mss ) : mss_( mss ) {}
+  CongestionControl( const CongestionControl& other ) = default;
+  CongestionControl( CongestionControl&& other ) = default;
+  CongestionControl& operator=( const CongestionControl& other ) = default;
+  CongestionControl& operator=( CongestionControl&& other ) = default;
+  virtual ~CongestionControl() = default;
+
+  virtual void on_ack( const AckEvent& ack ) = 0;
+  virtual void on_loss( uint64_t in_flight, uint64_t now_ms ) = 0;
+  virtual void on_rto( uint64_t in_flight, uint64_t now_ms ) = 0;
+  virtual void on_spurious_rto( uint64_t now_ms ) = 0; // Restore the state from before the last on_rto()
+
+  // Classic ECN treats a mark as a loss, minus the retransmission (RFC 3168 section 6.1.2)
+  virtual void on_ecn( uint64_t in_flight, uint64_t now_ms ) { on_loss( in_flight, now_ms ); }
+
+  virtual uint64_t cwnd() const = 0;                                 // Congestion window, in bytes
+  virtual std::optional<uint64_t> pacing_rate() const { return {}; } // Bytes per second, or unpaced
+
+  void set_mss( uint64_t mss ) { mss_ = mss; } // The peer advertised a different MSS
+
+protected:
+  uint64_t mss_; // Sender maximum segment size, in bytes
+};
+
+/* Construct the controller selected by `algorithm` (nullptr for CongestionControlAlgorithm::NONE) */
+std::unique_ptr<CongestionControl> make_congestion_control( CongestionControlAlgorithm algorithm, uint64_t mss );
+
+/*
+ * Reno with the NewReno refinement (RFC 5681, RFC 6582): slow start up to ssthresh, then one MSS
+ * per window of ACKed data. A loss halves the window; a timeout collapses it to one segment.
+ * Partial ACKs during recovery are handled by the sender, which keeps retransmitting holes
+ * without reporting a new loss event.
+ */
+class RenoCongestionControl : public CongestionControl
+{
+protected:
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  uint64_t bytes_acked_ {}; // Accumulates ACKed bytes in congestion avoidance (RFC 3465)
+  uint64_t prior_cwnd_ {};  // cwnd_ and ssthresh_ before the last timeout
+  uint64_t prior_ssthresh_ {};
+
+public:
+  explicit RenoCongestionControl( uint64_t mss )
+    : CongestionControl( mss ), cwnd_( INITIAL_WINDOW_SEGMENTS * mss )
+  {}
+
+  void on_ack( const AckEvent& ack ) override;
+  void on_loss( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_spurious_rto( uint64_t now_ms ) override;
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+};
+
+/*
+ * CUBIC (RFC 9438): after a loss, the window grows as a cubic function of the time since that
+ * loss, plateauing around the window where the loss happened (W_max) before probing beyond it.
+ * A Reno-equivalent estimate keeps it at least as aggressive as Reno on short-RTT paths.
+ */
+class CubicCongestionControl : public CongestionControl
+{
+  static constexpr double C = 0.4;
+  static constexpr double BETA = 0.7;
+
+  uint64_t cwnd_;
+  uint64_t ssthresh_ { UINT64_MAX };
+  double w_max_ {};                        // Window before the last reduction, in segments
+  double k_ {};                            // Seconds it takes to grow back to w_max_
+  double w_est_ {};                        // Reno-equivalent window, in segments
+  std::optional<uint64_t> epoch_start_ {}; // When the current congestion avoidance epoch began
+  uint64_t prior_cwnd_ {};                 // cwnd_, ssthresh_ and w_max_ before the last timeout
+  uint64_t prior_ssthresh_ {};
+  double prior_w_max_ {};
+
+  void reduce();
+
+public:
+  explicit CubicCongestionControl( uint64_t mss )
+    : CongestionControl( mss ), cwnd_( INITIAL_WINDOW_SEGMENTS * mss )
+  {}
+
+  void on_ack( const AckEvent& ack ) override;
+  void on_loss( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_rto( uint64_t in_flight, uint64_t now_ms ) override;
+  void on_spurious_rto( uint64_t now_ms ) override;
+
+  uint64_t cwnd() const override { return cwnd_; }
+  uint64_t ssthresh() const { return ssthresh_; }
+};
+
+/*
+ * DCTCP (RFC 8257): Reno, except that the response to ECN is proportional to the extent of the
+ * congestion. Once per window of data, the fraction F of acknowledged bytes that were marked feeds
+ * a moving average, alpha <- (1 - g) alpha + g F with g = 1/16, and a marked window is cut by
+ * alpha / 2 rather than half. With a shallow marking threshold at the switches, queues stay short
+ * without giving up throughput.
+ */
+class DCTCPCongestionControl : public RenoCongestionControl
+{
+  static constexpr double G = 1.0 / 16;
+
+  double alpha_ { 1 };     // Start out cautious, as RFC 8257 recommends
+  uint64_t window_end_ {}; // Delivered count at which the current observation window ends
+  uint64_t acked_ {};      // Bytes acknowledged in the current observation window
+  uint64_t marked_ {};     // and how many of them were marked
+
+public:
+  using RenoCongestionControl::RenoCongestionControl;
+
+  void on_ack( const AckEvent& ack ) override;
+  void on_ecn( uint64_t in_flight, uint64_t now_ms ) override;
+
+  double alpha() const { return alpha_; }
+};
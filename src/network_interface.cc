@@ -30,6 +30,14 @@ void NetworkInterface::send_arp_request( uint32_t next_hop )
     { EthernetHeader { ETHERNET_BROADCAST, ethernet_address_, EthernetHeader::TYPE_ARP }, serialize( arp ) } );
 }
 
+void NetworkInterface::arm_timer( uint32_t ip_address, Status& sts, uint64_t ms )
+{
+  if ( sts.timer_.has_value() ) {
+    timers_.cancel( sts.timer_.value() );
+  }
+  sts.timer_ = timers_.schedule( ms + 1, ip_address );
+}
+
 void NetworkInterface::add_mapping( uint32_t ip_address, EthernetAddress ethernet_address )
 {
   auto it = mapping_.find( ip_address );
@@ -40,7 +48,7 @@ void NetworkInterface::add_mapping( uint32_t ip_address, EthernetAddress etherne
   auto& sts = it->second.status_;
   sts.set_valid( true );
   sts.set_waiting( false );
-  sts.reset();
+  arm_timer( ip_address, sts, MappingExpiryTime );
   // Empty pending mesgs on this address
   while ( !sts.queue_.empty() ) {
     send_datagram( sts.queue_.front(), Address::from_ipv4_numeric( ip_address ) );
@@ -62,6 +70,16 @@ void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Addre
     auto& sts = it->second.status_;
     if ( sts.address_valid() ) {
       auto dst = it->second.ethernet_address_;
+      const uint8_t ecn = dgram.header.ecn();
+      if ( ecn_marking_threshold_.has_value() && ethernet_frames_.size() >= ecn_marking_threshold_.value()
+           && ( ecn == IPv4Header::ECN_ECT0 || ecn == IPv4Header::ECN_ECT1 ) ) {
+        InternetDatagram marked = dgram;
+        marked.header.set_ecn( IPv4Header::ECN_CE );
+        marked.header.compute_checksum();
+        ethernet_frames_.push(
+          { EthernetHeader { dst, ethernet_address_, EthernetHeader::TYPE_IPv4 }, serialize( marked ) } );
+        return;
+      }
       ethernet_frames_.push(
         { EthernetHeader { dst, ethernet_address_, EthernetHeader::TYPE_IPv4 }, serialize( dgram ) } );
     } else if ( !sts.waiting_for_reply() ) { // if either vailid nor waiting for reply
@@ -71,7 +89,7 @@ void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Addre
 
       // mark as waiting for reply
       sts.set_waiting( true );
-      sts.reset();
+      arm_timer( next_hop.ipv4_numeric(), sts, ARPWaitingTime );
       sts.queue_.push( dgram );
     } else { // If waiting for reply
       sts.queue_.push( dgram );
@@ -79,6 +97,7 @@ void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Addre
   } else { // if hit an address for the first time
     send_arp_request( next_hop.ipv4_numeric() );
     auto pair = mapping_.insert( { next_hop.ipv4_numeric(), {} } );
+    arm_timer( next_hop.ipv4_numeric(), pair.first->second.status_, ARPWaitingTime );
     pair.first->second.status_.queue_.push( dgram );
   }
 }
@@ -128,22 +147,22 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
 // ms_since_last_tick: the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  // NOTE! auto& !!! Don't forget &!!!
-  for ( auto& it : mapping_ ) {
-    auto& sts = it.second.status_;
+  // Timers are rearmed only after the wheel has advanced, so a long tick resends a request once
+  for ( const uint64_t tag : timers_.advance( ms_since_last_tick ) ) {
+    const auto ip_address = static_cast<uint32_t>( tag );
+    auto it = mapping_.find( ip_address );
+    if ( it == mapping_.end() ) {
+      continue;
+    }
+    auto& sts = it->second.status_;
+    sts.timer_.reset();
     if ( sts.address_valid() ) {
-      sts.add( ms_since_last_tick );
-      if ( !sts.check_valid() ) {
-        // mapping expired
-        sts.reset();
-      }
+      // mapping expired
+      sts.set_valid( false );
     } else if ( sts.waiting_for_reply() ) {
-      sts.add( ms_since_last_tick );
-      if ( sts.check_waiting() ) {
-        // waiting expired, resend arp request
-        sts.reset();
-        send_arp_request( it.first );
-      }
+      // waiting expired, resend arp request
+      send_arp_request( ip_address );
+      arm_timer( ip_address, sts, ARPWaitingTime );
     }
   }
 }
@@ -5,6 +5,7 @@
 #include "ethernet_frame.hh"
 #include "ethernet_header.hh"
 #include "ipv4_datagram.hh"
+#include "timing_wheel.hh"
 
 #include <cstdint>
 #include <iostream>
@@ -41,18 +42,14 @@ class NetworkInterface
 private:
   class Status
   {
-    uint64_t ms_ {};
     bool waiting_reply_ { true };
     bool address_valid_ { false };
 
   public:
     std::queue<InternetDatagram> queue_ {};
+    std::optional<TimingWheel::TimerId> timer_ {}; // Mapping expiry, or ARP retry while waiting
     bool waiting_for_reply() const { return waiting_reply_; }
     bool address_valid() const { return address_valid_; }
-    bool check_valid() { return address_valid_ = ms_ <= MappingExpiryTime; }
-    bool check_waiting() const { return ms_ > ARPWaitingTime; }
-    void add( uint64_t ms_to_add ) { ms_ += ms_to_add; }
-    void reset() { ms_ = 0; }
     void set_waiting( bool x ) { waiting_reply_ = x; }
     void set_valid( bool x ) { address_valid_ = x; }
   };
@@ -72,8 +69,17 @@ private:
   std::queue<EthernetFrame> ethernet_frames_ {};
   std::unordered_map<uint32_t, EthernetAddressWithStatus> mapping_ {};
 
+  // One timer per mapping, tagged with its IP address, so tick() visits only the entries that expire
+  TimingWheel timers_ {};
+
+  // Mark ECN-capable datagrams CE once this many frames are waiting to be sent
+  std::optional<size_t> ecn_marking_threshold_ {};
+
   void send_arp_request( uint32_t next_hop );
 
+  // (Re)start an entry's timer, to fire once more than `ms` milliseconds have passed
+  void arm_timer( uint32_t ip_address, Status& sts, uint64_t ms );
+
   void add_mapping( uint32_t ip_address, EthernetAddress ethernet_address );
 
 public:
@@ -99,4 +105,9 @@ public:
 
   // Called periodically when time elapses
   void tick( size_t ms_since_last_tick );
+
+  // Signal congestion with ECN (RFC 3168): while at least `frames` frames are queued for sending,
+  // outgoing ECN-capable datagrams are marked CE. As in DCTCP, the marking follows the instantaneous
+  // queue length, so a shallow threshold keeps the queue short.
+  void set_ecn_marking_threshold( size_t frames ) { ecn_marking_threshold_ = frames; }
 };
@@ -1,10 +1,14 @@
 #include "reassembler.hh"
 #include <algorithm>
 #include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
-void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring, Writer& output )
+void Reassembler::insert( uint64_t first_index, string_view data, bool is_last_substring, Writer& output )
 {
   if ( is_last_substring ) {
     _end = data.length() + first_index;
@@ -12,46 +16,62 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
   if ( _first_unassembled >= _end ) {
     output.close();
   }
-  _buffer.resize( output.capacity() );
-  _mark.resize( output.capacity() );
+  const uint64_t cap = output.capacity();
+  _buffer.resize( cap );
+  _mark.resize( cap );
   uint64_t l = max( first_index, _first_unassembled );
   uint64_t r = min( first_index + data.length(), output.bytes_pushed() + output.available_capacity() );
   if ( l >= r ) {
     return;
   }
-  for ( uint64_t i = _first_unassembled_pos + l - _first_unassembled; l < r; l++, i++ ) {
-    i -= i >= output.capacity() ? output.capacity() : 0;
-    _buffer[i] = data[l - first_index];
-    if ( !_mark[i] ) {
-      _mark[i] = 1;
-      _bytes_pending += 1;
-    }
-  }
-  if ( first_index <= _first_unassembled ) {
-    uint64_t i = _first_unassembled_pos;
-    do {
-      i -= i >= output.capacity() ? output.capacity() : 0;
+
+  if ( l > _first_unassembled ) {
+    // Out of order: hold the bytes until the gap before them is filled
+    for ( uint64_t i = _first_unassembled_pos + l - _first_unassembled; l < r; l++, i++ ) {
+      i -= i >= cap ? cap : 0;
+      _buffer[i] = data[l - first_index];
       if ( !_mark[i] ) {
-        break;
+        _mark[i] = 1;
+        _bytes_pending += 1;
       }
+    }
+    return;
+  }
+
+  // In order: the payload goes straight into the stream, without a stop in _buffer
+  output.push( data.substr( l - first_index, r - l ) );
+  uint64_t i = _first_unassembled_pos;
+  for ( uint64_t n = r - l; n > 0; n-- ) {
+    if ( _bytes_pending == 0 ) {
+      i = ( i + n ) % cap;
+      break;
+    }
+    if ( _mark[i] ) {
       _mark[i] = 0;
-      i++;
-    } while ( i != _first_unassembled_pos );
-    uint64_t written = 0;
-    if ( _first_unassembled_pos < i ) {
-      output.push( { _buffer.begin() + _first_unassembled_pos, _buffer.begin() + i } );
-      written = i - _first_unassembled_pos;
-    } else {
-      output.push( { _buffer.begin() + _first_unassembled_pos, _buffer.end() } );
-      output.push( { _buffer.begin(), _buffer.begin() + i } );
-      written = output.capacity() - _first_unassembled_pos + i;
+      _bytes_pending -= 1;
     }
+    i = i + 1 == cap ? 0 : i + 1;
+  }
+  _first_unassembled = r;
+  _first_unassembled_pos = i;
+
+  // Then flush whatever was waiting right behind it
+  uint64_t written = 0;
+  for ( ; written < _bytes_pending && _mark[i]; written++ ) {
+    _mark[i] = 0;
+    i = i + 1 == cap ? 0 : i + 1;
+  }
+  if ( written > 0 ) {
+    const string_view buffered = _buffer;
+    const uint64_t first_part = min( written, cap - _first_unassembled_pos );
+    output.push( buffered.substr( _first_unassembled_pos, first_part ) );
+    output.push( buffered.substr( 0, written - first_part ) );
     _first_unassembled += written;
     _bytes_pending -= written;
     _first_unassembled_pos = i;
-    if ( _first_unassembled >= _end ) {
-      output.close();
-    }
+  }
+  if ( _first_unassembled >= _end ) {
+    output.close();
   }
 }
 
@@ -59,3 +79,55 @@ uint64_t Reassembler::bytes_pending() const
 {
   return _bytes_pending;
 }
+
+uint64_t Reassembler::find_mark( char value, uint64_t offset ) const
+{
+  // The ring holds offsets [0, cap) from _first_unassembled starting at _first_unassembled_pos, so
+  // search the tail of the string first and then its head
+  const string_view mark = _mark;
+  const uint64_t cap = mark.size();
+  const uint64_t tail = cap - _first_unassembled_pos;
+  if ( offset < tail ) {
+    const size_t found = mark.find( value, _first_unassembled_pos + offset );
+    if ( found != string_view::npos ) {
+      return found - _first_unassembled_pos;
+    }
+    offset = tail;
+  }
+  const size_t found = mark.substr( 0, _first_unassembled_pos ).find( value, offset - tail );
+  return found == string_view::npos ? cap : found + tail;
+}
+
+vector<pair<uint64_t, uint64_t>> Reassembler::pending_ranges( size_t max_ranges ) const
+{
+  vector<pair<uint64_t, uint64_t>> ranges;
+  const uint64_t cap = _mark.size();
+  uint64_t found = 0;
+  for ( uint64_t offset = 0; found < _bytes_pending && ranges.size() < max_ranges; ) {
+    const uint64_t begin = find_mark( 1, offset );
+    if ( begin >= cap ) {
+      break;
+    }
+    offset = find_mark( 0, begin );
+    ranges.emplace_back( _first_unassembled + begin, _first_unassembled + offset );
+    found += offset - begin;
+  }
+  return ranges;
+}
+
+optional<pair<uint64_t, uint64_t>> Reassembler::pending_range_containing( uint64_t index ) const
+{
+  const uint64_t cap = _mark.size();
+  const auto marked = [&]( uint64_t offset ) {
+    const uint64_t i = _first_unassembled_pos + offset;
+    return _mark[i >= cap ? i - cap : i] != 0;
+  };
+  if ( index < _first_unassembled || index - _first_unassembled >= cap || !marked( index - _first_unassembled ) ) {
+    return {};
+  }
+  uint64_t begin = index - _first_unassembled;
+  while ( begin > 0 && marked( begin - 1 ) ) {
+    begin--;
+  }
+  return pair { _first_unassembled + begin, _first_unassembled + find_mark( 0, begin ) };
+}
@@ -4,7 +4,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 class Reassembler
 {
@@ -16,11 +20,15 @@ private:
   std::string _buffer {};
   std::string _mark {};
 
+  // Offset from _first_unassembled of the first byte at or after `offset` whose mark is `value`
+  uint64_t find_mark( char value, uint64_t offset ) const;
+
 public:
   /*
    * Insert a new substring to be reassembled into a ByteStream.
    *   `first_index`: the index of the first byte of the substring
-   *   `data`: the substring itself
+   *   `data`: the substring itself (a view into the caller's payload; in-order bytes are written
+   *           straight to the output, so they are copied exactly once)
    *   `is_last_substring`: this substring represents the end of the stream
    *   `output`: a mutable reference to the Writer
    *
@@ -37,9 +45,15 @@ public:
    *
    * The Reassembler should close the stream after writing the last byte.
    */
-  void insert( uint64_t first_index, std::string data, bool is_last_substring, Writer& output );
+  void insert( uint64_t first_index, std::string_view data, bool is_last_substring, Writer& output );
 
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
   uint64_t first_unassembled() const { return _first_unassembled; }
+
+  // The lowest `max_ranges` [begin, end) stream index ranges held out of order, in increasing order
+  std::vector<std::pair<uint64_t, uint64_t>> pending_ranges( size_t max_ranges ) const;
+
+  // The [begin, end) range held out of order that includes `index`, if any
+  std::optional<std::pair<uint64_t, uint64_t>> pending_range_containing( uint64_t index ) const;
 };
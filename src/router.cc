@@ -51,7 +51,8 @@ void Router::route_datagram( InternetDatagram dgram )
   }
   if ( match_length >= 0 ) {
     cerr << "sent datagram\n";
-    dgram.header.ttl--; // this made dgram bad,,, why???
+    dgram.header.ttl--;
+    dgram.header.compute_checksum(); // the TTL is covered by the header checksum
     cerr << dgram.header.to_string() << " ttl is " << (int)dgram.header.ttl << endl;
     Router::interface( interface_num )
       .send_datagram( dgram, next_hop.value_or( Address::from_ipv4_numeric( ip_address ) ) );
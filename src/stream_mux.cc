@@ -0,0 +1,225 @@
+#include "stream_mux.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+enum FrameType : uint8_t
+{
+  PADDING, // Zeros to the end of the block
+  DATA,
+  WINDOW,
+};
+
+constexpr uint8_t FLAG_FIN = 1;
+
+template<typename T>
+void put( string& out, T value )
+{
+  for ( size_t i = sizeof( T ); i > 0; i-- ) {
+    out.push_back( static_cast<char>( value >> ( 8 * ( i - 1 ) ) ) );
+  }
+}
+
+template<typename T>
+T get( string_view in, size_t pos )
+{
+  T value {};
+  for ( size_t i = 0; i < sizeof( T ); i++ ) {
+    value = static_cast<T>( value << 8 | static_cast<uint8_t>( in[pos + i] ) );
+  }
+  return value;
+}
+
+} // namespace
+
+StreamMux::StreamMux( const MuxConfig& config ) : config_( config )
+{
+  streams_.reserve( config_.streams );
+  for ( uint16_t i = 0; i < config_.streams; i++ ) {
+    streams_.push_back( Stream { ByteStream { config_.stream_window },
+                                 ByteStream { config_.stream_window },
+                                 {},
+                                 config_.stream_window,
+                                 config_.stream_window,
+                                 false } );
+  }
+}
+
+StreamMux::Frame StreamMux::decode( string_view header )
+{
+  return Frame { get<uint8_t>( header, 0 ),
+                 ( get<uint8_t>( header, 1 ) & FLAG_FIN ) != 0,
+                 get<uint16_t>( header, 2 ),
+                 get<uint64_t>( header, 4 ),
+                 get<uint16_t>( header, 12 ) };
+}
+
+void StreamMux::apply( const Frame& frame, string_view payload )
+{
+  if ( frame.id >= streams_.size() ) {
+    return;
+  }
+  Stream& stream = streams_[frame.id];
+  if ( frame.type == DATA ) {
+    stream.reassembler.insert(
+      frame.offset, payload, frame.fin && payload.size() == frame.length, stream.inbound.writer() );
+  } else if ( frame.type == WINDOW ) {
+    // Window updates may be seen twice (out of order, then in order), or overtaken by a later one
+    stream.peer_limit = max( stream.peer_limit, frame.offset );
+  }
+}
+
+optional<uint64_t> StreamMux::make_room( Writer& connection ) const
+{
+  uint64_t block_left = config_.block_size - connection.bytes_pushed() % config_.block_size;
+  if ( block_left <= MuxConfig::HEADER_SIZE ) {
+    if ( connection.available_capacity() < block_left ) {
+      return nullopt;
+    }
+    connection.push( string( block_left, PADDING ) );
+    block_left = config_.block_size;
+  }
+  if ( connection.available_capacity() < MuxConfig::HEADER_SIZE ) {
+    return nullopt;
+  }
+  return min( block_left, connection.available_capacity() ) - MuxConfig::HEADER_SIZE;
+}
+
+void StreamMux::push( Writer& connection )
+{
+  // Return credit for what the application has read, once it adds up to half a window
+  for ( uint16_t id = 0; id < streams_.size(); id++ ) {
+    Stream& stream = streams_[id];
+    const uint64_t limit = stream.inbound.reader().bytes_popped() + config_.stream_window;
+    if ( limit - stream.advertised_limit < config_.stream_window / 2 ) {
+      continue;
+    }
+    if ( !make_room( connection ).has_value() ) {
+      return;
+    }
+    string header;
+    put<uint8_t>( header, WINDOW );
+    put<uint8_t>( header, 0 );
+    put<uint16_t>( header, id );
+    put<uint64_t>( header, limit );
+    put<uint16_t>( header, 0 );
+    connection.push( header );
+    stream.advertised_limit = limit;
+  }
+
+  // Then one frame per stream with something to send, in turn, until there's nothing or no room
+  bool progress = true;
+  while ( progress ) {
+    progress = false;
+    for ( uint16_t i = 0; i < streams_.size(); i++ ) {
+      const uint16_t id = next_stream_;
+      next_stream_ = ( next_stream_ + 1 ) % streams_.size();
+
+      Stream& stream = streams_[id];
+      Reader& source = stream.outbound.reader();
+      const uint64_t ready = min( source.bytes_buffered(), stream.peer_limit - source.bytes_popped() );
+      const bool fin_ready = stream.outbound.writer().is_closed() && !stream.fin_sent;
+      if ( ready == 0 && !( fin_ready && source.bytes_buffered() == 0 ) ) {
+        continue;
+      }
+      const optional<uint64_t> room = make_room( connection );
+      if ( !room.has_value() ) {
+        return;
+      }
+      const uint64_t len = min( { ready, room.value(), uint64_t { UINT16_MAX } } );
+      const bool fin = fin_ready && len == source.bytes_buffered();
+      if ( len == 0 && !fin ) {
+        return;
+      }
+
+      string frame;
+      frame.reserve( MuxConfig::HEADER_SIZE + len );
+      put<uint8_t>( frame, DATA );
+      put<uint8_t>( frame, fin ? FLAG_FIN : 0 );
+      put<uint16_t>( frame, id );
+      put<uint64_t>( frame, source.bytes_popped() );
+      put<uint16_t>( frame, static_cast<uint16_t>( len ) );
+      while ( frame.size() < MuxConfig::HEADER_SIZE + len ) {
+        const string_view data = source.peek().substr( 0, MuxConfig::HEADER_SIZE + len - frame.size() );
+        frame.append( data );
+        source.pop( data.size() );
+      }
+      connection.push( frame );
+      stream.fin_sent |= fin;
+      progress = true;
+    }
+  }
+}
+
+uint64_t StreamMux::parse( string_view data )
+{
+  if ( frame_remaining_ > 0 ) {
+    const uint64_t len = min( frame_remaining_, data.size() );
+    Frame rest = frame_;
+    rest.offset += frame_.length - frame_remaining_;
+    rest.length = static_cast<uint16_t>( frame_remaining_ );
+    apply( rest, data.substr( 0, len ) );
+    frame_remaining_ -= len;
+    return len;
+  }
+
+  if ( header_.empty() && static_cast<uint8_t>( data.front() ) == PADDING ) {
+    return min<uint64_t>( data.size(), config_.block_size - parsed_ % config_.block_size );
+  }
+
+  const uint64_t len = min( MuxConfig::HEADER_SIZE - header_.size(), data.size() );
+  header_.append( data.substr( 0, len ) );
+  if ( header_.size() == MuxConfig::HEADER_SIZE ) {
+    frame_ = decode( header_ );
+    header_.clear();
+    frame_remaining_ = frame_.type == DATA ? frame_.length : 0;
+    if ( frame_remaining_ == 0 ) {
+      apply( frame_, {} );
+    }
+  }
+  return len;
+}
+
+void StreamMux::receive( Reader& connection )
+{
+  while ( connection.bytes_buffered() > 0 ) {
+    const string_view data = connection.peek();
+    for ( uint64_t used = 0; used < data.size(); ) {
+      const uint64_t len = parse( data.substr( used ) );
+      used += len;
+      parsed_ += len;
+    }
+    connection.pop( data.size() );
+  }
+}
+
+void StreamMux::segment_received( uint64_t index, string_view payload )
+{
+  if ( index + payload.size() <= parsed_ ) {
+    return; // Already parsed in order
+  }
+  uint64_t pos = ( config_.block_size - index % config_.block_size ) % config_.block_size;
+  while ( pos + MuxConfig::HEADER_SIZE <= payload.size() ) {
+    if ( static_cast<uint8_t>( payload[pos] ) == PADDING ) {
+      pos += config_.block_size - ( index + pos ) % config_.block_size;
+      continue;
+    }
+    const Frame frame = decode( payload.substr( pos, MuxConfig::HEADER_SIZE ) );
+    const uint64_t length = frame.type == DATA ? frame.length : 0;
+    apply( frame, payload.substr( pos + MuxConfig::HEADER_SIZE, length ) );
+    pos += MuxConfig::HEADER_SIZE + length;
+  }
+}
+
+uint64_t StreamMux::send_credit( uint16_t id ) const
+{
+  const Stream& stream = streams_.at( id );
+  return stream.peer_limit - stream.outbound.reader().bytes_popped();
+}
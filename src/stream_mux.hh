@@ -0,0 +1,103 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! Config for a StreamMux (both ends of a connection must agree on it)
+struct MuxConfig
+{
+  static constexpr uint64_t HEADER_SIZE = 14; //!< type, flags, stream id, offset, length
+
+  uint16_t streams = 16;                             //!< Number of streams, with ids 0 to streams - 1
+  uint64_t stream_window = 16384;                    //!< Per-stream receive buffer, and the initial credit
+  uint64_t block_size = TCPConfig::MAX_PAYLOAD_SIZE; //!< A frame header starts every this many bytes
+};
+
+/*
+ * Many bidirectional byte streams multiplexed over one TCP connection's pair of ByteStreams.
+ *
+ * Each stream's bytes travel in frames that name the stream and the offset within it, and each
+ * stream is flow controlled on its own: the peer grants credit with WINDOW frames as the
+ * application reads, so one stalled reader can't fill the connection.
+ *
+ * Frames never straddle a multiple of `block_size` in the connection's stream (the tail of a
+ * block too short for a header is padded with zeros), so a frame header starts at every block
+ * boundary. That lets segment_received() find the frames in a segment that arrived after a hole,
+ * and deliver their bytes to streams the hole doesn't concern, without waiting for the
+ * connection's Reassembler to fill it in.
+ */
+class StreamMux
+{
+private:
+  struct Stream
+  {
+    ByteStream outbound;
+    ByteStream inbound;
+    Reassembler reassembler {};
+    uint64_t peer_limit;       // Bytes of the outbound stream the peer has room for
+    uint64_t advertised_limit; // Bytes of the inbound stream the peer was told we have room for
+    bool fin_sent {};
+  };
+
+  struct Frame
+  {
+    uint8_t type {};
+    bool fin {};
+    uint16_t id {};
+    uint64_t offset {}; // DATA: the stream offset of the first payload byte; WINDOW: the new limit
+    uint16_t length {}; // Payload bytes that follow the header
+  };
+
+  MuxConfig config_;
+  std::vector<Stream> streams_ {};
+  uint16_t next_stream_ {}; // Round-robin position
+
+  // In-order parsing of the connection's inbound stream
+  uint64_t parsed_ {};          // Index of the next byte of the connection stream to parse
+  std::string header_ {};       // A header split across reads
+  Frame frame_ {};              // The frame whose payload is being parsed...
+  uint64_t frame_remaining_ {}; // ...and how much of it is still to come
+
+  static Frame decode( std::string_view header );
+
+  // Parses some of the in-order `data` at parsed_; returns how many bytes it consumed
+  uint64_t parse( std::string_view data );
+
+  // Acts on a frame, given all or (from the front) part of its payload
+  void apply( const Frame& frame, std::string_view payload );
+
+  // Pads out the block if a header won't fit before its end; returns the payload room after a
+  // header written next, or nothing if the connection can't take a header
+  std::optional<uint64_t> make_room( Writer& connection ) const;
+
+public:
+  explicit StreamMux( const MuxConfig& config = {} );
+
+  // The application's ends of stream `id`
+  Writer& outbound( uint16_t id ) { return streams_.at( id ).outbound.writer(); }
+  Reader& inbound( uint16_t id ) { return streams_.at( id ).inbound.reader(); }
+
+  // Frames window updates and pending stream data (round-robin over streams) into the connection
+  void push( Writer& connection );
+
+  // Parses the connection's in-order bytes, delivering each stream's data and taking in credit
+  void receive( Reader& connection );
+
+  /*
+   * Delivers what can be parsed of a segment's payload as soon as it arrives, in order or not.
+   * `index` is the connection stream index of its first byte (see TCPReceiver::stream_index()).
+   * Frames are found from the first block boundary in the segment; bytes before that, or cut
+   * off at its end, arrive later through receive().
+   */
+  void segment_received( uint64_t index, std::string_view payload );
+
+  // Bytes stream `id` may still send before the peer grants more credit
+  uint64_t send_credit( uint16_t id ) const;
+};
@@ -0,0 +1,136 @@
+#include "tcp_peer.hh"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+using namespace std;
+
+TCPPeer::TCPPeer( const TCPConfig& config )
+  : config_( config )
+  , outbound_( config.send_capacity )
+  , inbound_( config.recv_capacity )
+  , sender_( config )
+  , receiver_( config )
+{}
+
+void TCPPeer::connect()
+{
+  started_ = true;
+  push();
+}
+
+void TCPPeer::push()
+{
+  if ( !started_ || aborted_ ) {
+    return;
+  }
+  sender_.push( outbound_.reader() );
+
+  // One acknowledgment, current as of now, rides on everything that goes out
+  const TCPReceiverMessage reply = receiver_.send( inbound_.writer() );
+  const size_t sent = sender_.transmit( [&]( const TCPSenderMessage& message ) {
+    if ( !config_.super_segments ) {
+      messages_out_.push( { message, reply } );
+      return;
+    }
+    // The last stop before the wire: cut a super segment into segments the peer can take
+    for ( TCPSenderMessage& piece : message.split( sender_.mss() ) ) {
+      messages_out_.push( { std::move( piece ), reply } );
+    }
+  } );
+  if ( sent == 0 && need_ack_ ) {
+    messages_out_.push( { sender_.send_empty_message(), reply } );
+  }
+  need_ack_ = false;
+}
+
+void TCPPeer::receive( const TCPMessage& message )
+{
+  if ( !active() || ( !started_ && !message.sender.SYN ) ) {
+    return;
+  }
+  started_ = true;
+  last_receipt_ms_ = time_ms_;
+
+  // Anything that takes up sequence numbers is acknowledged, and so is a bare segment that isn't
+  // at the ackno, such as a keep-alive or a duplicate (RFC 9293 section 3.10.7.4)
+  const optional<Wrap32> ackno = receiver_.send( inbound_.writer() ).ackno;
+  need_ack_ |= message.sender.sequence_length() > 0
+               || ( ackno.has_value() && !( message.sender.seqno == ackno.value() ) );
+  receiver_.receive( message.sender, reassembler_, inbound_.writer() );
+
+  // The peer closed first, so its FIN_WAIT lingers on its side: ours needn't
+  if ( inbound_.writer().is_closed() && !sender_.fin_sent() ) {
+    linger_ = false;
+  }
+
+  sender_.receive( message.receiver );
+  push();
+}
+
+void TCPPeer::tick( uint64_t ms_since_last_tick )
+{
+  if ( !active() ) {
+    return;
+  }
+  time_ms_ += ms_since_last_tick;
+  sender_.tick( ms_since_last_tick );
+  if ( sender_.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS ) {
+    inbound_.writer().set_error();
+    outbound_.writer().set_error();
+    aborted_ = true;
+    messages_out_ = {};
+    return;
+  }
+  push();
+}
+
+optional<TCPMessage> TCPPeer::maybe_send()
+{
+  if ( messages_out_.empty() ) {
+    return nullopt;
+  }
+  TCPMessage message = std::move( messages_out_.front() );
+  messages_out_.pop();
+  return message;
+}
+
+bool TCPPeer::active() const
+{
+  if ( aborted_ ) {
+    return false;
+  }
+  const bool done
+    = inbound_.writer().is_closed() && sender_.fin_sent() && sender_.sequence_numbers_in_flight() == 0;
+  return !done || ( linger_ && time_ms_ < last_receipt_ms_ + 10 * uint64_t { config_.rt_timeout } );
+}
+
+TCPState TCPPeer::state() const
+{
+  if ( aborted_ ) {
+    return TCPState::CLOSED;
+  }
+  const bool syn_received = receiver_.send( inbound_.writer() ).ackno.has_value();
+  if ( !sender_.syn_sent() ) {
+    return TCPState::LISTEN;
+  }
+  if ( !syn_received ) {
+    return TCPState::SYN_SENT;
+  }
+  if ( !sender_.syn_acked() ) {
+    return TCPState::SYN_RECEIVED;
+  }
+  const bool inbound_done = inbound_.writer().is_closed();
+  if ( !sender_.fin_sent() ) {
+    return inbound_done ? TCPState::CLOSE_WAIT : TCPState::ESTABLISHED;
+  }
+  const bool fin_acked = sender_.sequence_numbers_in_flight() == 0;
+  if ( !inbound_done ) {
+    return fin_acked ? TCPState::FIN_WAIT_2 : TCPState::FIN_WAIT_1;
+  }
+  if ( !fin_acked ) {
+    return linger_ ? TCPState::CLOSING : TCPState::LAST_ACK;
+  }
+  return active() ? TCPState::TIME_WAIT : TCPState::CLOSED;
+}
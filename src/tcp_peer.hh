@@ -0,0 +1,94 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+
+#include <cstdint>
+#include <optional>
+#include <queue>
+
+//! Connection states (RFC 9293 section 3.3.2)
+enum class TCPState
+{
+  LISTEN,       //!< Waiting for a SYN
+  SYN_SENT,     //!< Sent a SYN, waiting for the peer's
+  SYN_RECEIVED, //!< Both SYNs seen, waiting for ours to be acknowledged
+  ESTABLISHED,  //!< Both directions open
+  FIN_WAIT_1,   //!< Outbound ended, FIN not yet acknowledged
+  FIN_WAIT_2,   //!< Outbound ended and acknowledged, inbound still open
+  CLOSING,      //!< Both ended, our FIN (sent first) not yet acknowledged
+  TIME_WAIT,    //!< Both ended and acknowledged, lingering in case the peer retransmits its FIN
+  CLOSE_WAIT,   //!< Inbound ended, outbound still open
+  LAST_ACK,     //!< Both ended, our FIN (sent last) not yet acknowledged
+  CLOSED,       //!< Done, or aborted after too many retransmissions
+};
+
+/*
+ * One end of a TCP connection: a TCPSender for the outbound stream and a TCPReceiver for the
+ * inbound one, run together.
+ *
+ * Every message carries the receiver's current acknowledgment along with whatever the sender has
+ * to send, so ACKs ride on data whenever there is data; a bare ACK goes out only when something
+ * that needs acknowledging arrived and nothing was going the other way anyway.
+ * With TCPConfig::super_segments, each of the sender's super segments is split to the MSS here,
+ * so only segments of at most the MSS reach the other peer or the wire.
+ *
+ * The connection's state follows from the two halves' progress (see state()). A peer that sent
+ * its FIN before the other's arrived lingers for ten initial timeouts after the last segment
+ * it receives, to acknowledge a retransmitted FIN; the other peer is done as soon as its FIN is
+ * acknowledged. There are no RST segments: a connection that retransmits more than
+ * MAX_RETX_ATTEMPTS times in a row is aborted, with an error set on both streams.
+ */
+class TCPPeer
+{
+private:
+  TCPConfig config_;
+  ByteStream outbound_;
+  ByteStream inbound_;
+  TCPSender sender_;
+  TCPReceiver receiver_;
+  Reassembler reassembler_ {};
+  std::queue<TCPMessage> messages_out_ {};
+
+  bool started_ {};      // connect() was called, or a SYN arrived
+  bool need_ack_ {};     // Something arrived that calls for an acknowledgment
+  bool linger_ { true }; // Wait in TIME_WAIT once both streams are done
+  bool aborted_ {};
+  uint64_t time_ms_ {};
+  uint64_t last_receipt_ms_ {};
+
+public:
+  explicit TCPPeer( const TCPConfig& config );
+
+  // Active open: send a SYN (with any data already written). A peer that isn't told to connect
+  // waits in LISTEN for the other's SYN.
+  void connect();
+
+  // The application's ends of the two streams
+  Writer& outbound_writer() { return outbound_.writer(); }
+  Reader& inbound_reader() { return inbound_.reader(); }
+
+  // Send what the application has written (and closed) so far, as the windows allow
+  void push();
+
+  // Receive a message from the other peer
+  void receive( const TCPMessage& message );
+
+  // Time has passed by the given # of milliseconds since the last time the tick() method was called
+  void tick( uint64_t ms_since_last_tick );
+
+  // The next message to send to the other peer, if any
+  std::optional<TCPMessage> maybe_send();
+
+  // Is the connection still going (or lingering)?
+  bool active() const;
+
+  TCPState state() const;
+
+  const TCPSender& sender() const { return sender_; }
+  const TCPReceiver& receiver() const { return receiver_; }
+};
@@ -1,32 +1,164 @@
 #include "tcp_receiver.hh"
 #include "byte_stream.hh"
+#include "ipv4_header.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "wrapping_integers.hh"
 #include <cstdint>
 #include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
-void TCPReceiver::receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream )
+optional<uint64_t> TCPReceiver::admit( const TCPSenderMessage& message, const Reassembler& reassembler )
 {
   Wrap32 seqno( message.seqno );
   if ( message.SYN ) {
     _zero_point = seqno;
+    _ts_recent = message.TSval;
+  } else if ( message.TSval.has_value() && _ts_recent.has_value()
+              && static_cast<int32_t>( message.TSval.value() - _ts_recent.value() ) < 0 ) {
+    return nullopt; // PAWS: timestamp is older than the last one accepted
   }
-  if ( _zero_point.has_value() ) {
-    uint64_t first_index = seqno.unwrap( _zero_point.value(), reassembler.first_unassembled() );
-    if ( !message.SYN ) {
-      first_index--;
+  if ( !_zero_point.has_value() ) {
+    return nullopt;
+  }
+  if ( _precise_ecn_echo ) {
+    _ece = message.ECN == IPv4Header::ECN_CE;
+  } else {
+    _ece = ( _ece && !message.CWR ) || message.ECN == IPv4Header::ECN_CE;
+  }
+  uint64_t first_index = seqno.unwrap( _zero_point.value(), reassembler.first_unassembled() );
+  if ( !message.SYN ) {
+    first_index--;
+    // Only a segment that starts at or before the ackno may update the echoed timestamp
+    if ( message.TSval.has_value() && first_index <= reassembler.first_unassembled() ) {
+      _ts_recent = message.TSval;
     }
-    reassembler.insert( first_index, message.payload, message.FIN, inbound_stream );
-    _ackno = Wrap32::wrap( reassembler.first_unassembled() + 1, _zero_point.value() );
-    if ( message.FIN ) {
-      _fin_aseqno = first_index + message.payload.size();
+  }
+  return first_index;
+}
+
+void TCPReceiver::insert( uint64_t first_index,
+                          string_view payload,
+                          bool fin,
+                          Reassembler& reassembler,
+                          Writer& inbound_stream )
+{
+  reassembler.insert( first_index, payload, fin, inbound_stream );
+  if ( fin ) {
+    _fin_aseqno = first_index + payload.size();
+  }
+}
+
+void TCPReceiver::acknowledge( uint64_t first_index, const Reassembler& reassembler )
+{
+  _ackno = Wrap32::wrap( reassembler.first_unassembled() + 1, _zero_point.value() );
+  if ( _fin_aseqno == reassembler.first_unassembled() ) {
+    _ackno = _ackno.value() + 1;
+  }
+
+  // The block holding this segment goes first (RFC 2018), then the lowest others
+  _sack_blocks.clear();
+  const auto latest = reassembler.pending_range_containing( first_index );
+  const auto to_block = [&]( const pair<uint64_t, uint64_t>& range ) {
+    return SACKBlock { Wrap32::wrap( range.first + 1, _zero_point.value() ),
+                       Wrap32::wrap( range.second + 1, _zero_point.value() ) };
+  };
+  if ( latest.has_value() ) {
+    _sack_blocks.push_back( to_block( latest.value() ) );
+  }
+  for ( const auto& range : reassembler.pending_ranges( TCPConfig::MAX_SACK_BLOCKS ) ) {
+    if ( _sack_blocks.size() < TCPConfig::MAX_SACK_BLOCKS && range != latest ) {
+      _sack_blocks.push_back( to_block( range ) );
     }
-    if ( _fin_aseqno == reassembler.first_unassembled() ) {
-      _ackno = _ackno.value() + 1;
+  }
+}
+
+void TCPReceiver::receive( const TCPSenderMessage& message, Reassembler& reassembler, Writer& inbound_stream )
+{
+  const optional<uint64_t> first_index = admit( message, reassembler );
+  if ( first_index.has_value() ) {
+    insert( first_index.value(), message.payload, message.FIN, reassembler, inbound_stream );
+    acknowledge( first_index.value(), reassembler );
+  }
+}
+
+void TCPReceiver::receive_batch( span<const TCPSenderMessage> messages,
+                                 Reassembler& reassembler,
+                                 Writer& inbound_stream )
+{
+  _segments_coalesced = 0;
+  optional<uint64_t> run_end {};    // Stream index just past the open run, if there is one
+  uint64_t last_index = 0;          // Stream index of the run's latest segment
+  bool run_finished = false;        // The run ended with a FIN
+  uint8_t run_ecn = 0;              // The run's ECN codepoint
+  optional<uint64_t> held_index {}; // Stream index of the run's payload not yet inserted,
+  Buffer held {};                   // which is the latest segments' slices joined into one
+  const auto insert_held = [&] {
+    if ( held_index.has_value() ) {
+      insert( held_index.value(), held, run_finished, reassembler, inbound_stream );
+      held_index.reset();
+    }
+  };
+
+  for ( const TCPSenderMessage& message : messages ) {
+    // A payload that doesn't carry on from the held one in memory can't share its insert; that goes
+    // in now, so admit() sees the Reassembler as it stands
+    const optional<Buffer> joined = held_index.has_value() ? held.joined( message.payload ) : nullopt;
+    if ( !joined.has_value() ) {
+      insert_held();
     }
+    // Each segment passes PAWS (against the timestamp echoed so far) on its own before it joins a run
+    const optional<uint32_t> ts_recent = _ts_recent;
+    const optional<uint64_t> first_index = admit( message, reassembler );
+    // A change of CE marking (or a CWR) ends the run, so that the ACK answering it goes out at once
+    const bool joins = first_index.has_value() && run_end.has_value() && !run_finished && !message.SYN
+                       && !message.CWR && message.ECN == run_ecn && first_index.value() == run_end.value();
+    if ( joins ) {
+      // The run is acknowledged once, so only its head was at the last ackno sent: the echo stays
+      // the earliest TSval of the run, as for a delayed ACK (RFC 7323 section 4.3)
+      _ts_recent = ts_recent;
+    }
+    if ( run_end.has_value() && !joins ) {
+      insert_held();
+      acknowledge( last_index, reassembler );
+      run_end.reset();
+    }
+    if ( !first_index.has_value() ) {
+      continue; // A rejected segment never starts a run
+    }
+    _segments_coalesced += joins;
+
+    // The payload waits to go in with the rest of its run; so does the bookkeeping
+    if ( held_index.has_value() ) {
+      held = joined.value();
+    } else {
+      held_index = first_index;
+      held = message.payload;
+    }
+    last_index = first_index.value();
+    run_end = first_index.value() + message.payload.size();
+    run_finished = message.FIN;
+    run_ecn = message.ECN;
+  }
+  if ( run_end.has_value() ) {
+    insert_held();
+    acknowledge( last_index, reassembler );
+  }
+}
+
+optional<uint64_t> TCPReceiver::stream_index( const TCPSenderMessage& message, const Reassembler& reassembler ) const
+{
+  if ( message.SYN ) {
+    return 0;
+  }
+  if ( !_zero_point.has_value() ) {
+    return nullopt;
   }
+  return message.seqno.unwrap( _zero_point.value(), reassembler.first_unassembled() ) - 1;
 }
 
 TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
@@ -35,5 +167,5 @@ TCPReceiverMessage TCPReceiver::send( const Writer& inbound_stream ) const
   if ( inbound_stream.available_capacity() < UINT16_MAX ) {
     window_size = inbound_stream.available_capacity();
   }
-  return TCPReceiverMessage { _ackno, window_size };
+  return TCPReceiverMessage { _ackno, window_size, _ts_recent, _sack_blocks, _mss, _ece };
 }
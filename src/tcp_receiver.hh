@@ -1,10 +1,14 @@
 #pragma once
 
 #include "reassembler.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include "wrapping_integers.hh"
 #include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
 
 class TCPReceiver
 {
@@ -12,13 +16,72 @@ private:
   std::optional<Wrap32> _zero_point {};
   std::optional<Wrap32> _ackno {};
   uint64_t _fin_aseqno = -1;
+  std::optional<uint32_t> _ts_recent {}; // TSval to echo, see RFC 7323 section 4.3
+  uint64_t _segments_coalesced {};
+  std::vector<SACKBlock> _sack_blocks {}; // Out-of-order data to advertise, see RFC 2018
+  uint16_t _mss = TCPConfig::MAX_PAYLOAD_SIZE;
+  bool _ece {};              // Echo congestion experienced to the sender
+  bool _precise_ecn_echo {}; // DCTCP: echo each segment's CE as it comes (RFC 8257 section 3.2)
+
+  // Take in a segment's SYN, timestamp and ECN marking; the stream index of its first payload byte,
+  // or nothing if it's dropped (before the SYN, or by PAWS)
+  std::optional<uint64_t> admit( const TCPSenderMessage& message, const Reassembler& reassembler );
+
+  // Hand admitted payload (and FIN) to the Reassembler
+  void insert( uint64_t first_index,
+               std::string_view payload,
+               bool fin,
+               Reassembler& reassembler,
+               Writer& inbound_stream );
+
+  // Bring the ackno and SACK blocks up to date, the latest segment having started at `first_index`
+  void acknowledge( uint64_t first_index, const Reassembler& reassembler );
 
 public:
+  TCPReceiver() = default;
+
+  /* Construct a receiver that advertises `mss` as the largest payload it accepts */
+  explicit TCPReceiver( uint16_t mss ) : _mss( mss ) {}
+
+  /* Construct a receiver from a connection's configuration */
+  explicit TCPReceiver( const TCPConfig& config )
+    : _mss( config.mss ), _precise_ecn_echo( config.congestion_control == CongestionControlAlgorithm::DCTCP )
+  {}
+
   /*
    * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
    * at the correct stream index.
+   *
+   * Segments carrying a TSval older than the last one echoed are dropped (PAWS): with the
+   * sequence space wrapping in under a second at high rates, the timestamp is what tells an
+   * old duplicate apart from new data that unwraps to the same index.
+   *
+   * Data held out of order by the Reassembler is advertised back to the sender as SACK blocks.
+   *
+   * A segment that arrived marked CE sets ECE on the following ACKs until the sender answers
+   * with CWR (RFC 3168), or, for DCTCP, on the ACKs of marked segments only.
    */
-  void receive( TCPSenderMessage message, Reassembler& reassembler, Writer& inbound_stream );
+  void receive( const TCPSenderMessage& message, Reassembler& reassembler, Writer& inbound_stream );
+
+  /*
+   * Receive a burst of TCPSenderMessages at once. Each segment is checked (PAWS included) and its
+   * payload handed to the Reassembler without copying. Runs of back-to-back segments (each one
+   * starting where the previous one ended) share one round of ackno and SACK bookkeeping, and
+   * payloads sliced one after another from the same storage (as the sender slices them from its
+   * stream) go in with a single Reassembler insert.
+   */
+  void receive_batch( std::span<const TCPSenderMessage> messages,
+                      Reassembler& reassembler,
+                      Writer& inbound_stream );
+
+  /*
+   * The inbound stream index of a message's first payload byte, or nothing before the SYN.
+   * Lets a layer above (such as a StreamMux) look at data the Reassembler is still holding.
+   */
+  std::optional<uint64_t> stream_index( const TCPSenderMessage& message, const Reassembler& reassembler ) const;
+
+  /* How many segments joined a preceding one's run in the last receive_batch()? */
+  uint64_t segments_coalesced() const { return _segments_coalesced; }
 
   /* The TCPReceiver sends TCPReceiverMessages back to the TCPSender. */
   TCPReceiverMessage send( const Writer& inbound_stream ) const;
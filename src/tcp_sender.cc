@@ -1,146 +1,48 @@
 #include "tcp_sender.hh"
-#include "tcp_config.hh"
-#include "tcp_sender_message.hh"
-#include "wrapping_integers.hh"
 
+#include <algorithm>
 #include <cstdint>
-#include <random>
-#include <string_view>
+#include <optional>
 
 using namespace std;
 
-/* TCPSender constructor (uses a random ISN if none given) */
-TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn )
-  : isn_( fixed_isn.value_or( Wrap32 { random_device()() } ) )
-  , initial_RTO_ms_( initial_RTO_ms )
-  , ackno_( isn_ )
-  , next_seqno_( isn_ )
-  , timer_( initial_RTO_ms_ )
-{}
-
-uint64_t TCPSender::sequence_numbers_in_flight() const
-{
-  return sequence_numbers_in_flight_;
-}
-
-uint64_t TCPSender::consecutive_retransmissions() const
-{
-  return consecutive_retransmissions_;
-}
-
-optional<TCPSenderMessage> TCPSender::maybe_send()
+void RTTEstimator::sample( uint64_t rtt_ms )
 {
-  optional<TCPSenderMessage> mesg {};
-  if ( !sender_messages_.empty() ) {
-    mesg = std::move( sender_messages_.front() );
-    sender_messages_.pop_front();
-    // Only new mesgs will be pushed back. Retxs will stay in queue.
-    if ( outstanding_messages_.empty()
-         || mesg->seqno.unwrap( isn_, checkpoint_ )
-              > outstanding_messages_.back().seqno.unwrap( isn_, checkpoint_ ) ) {
-      outstanding_messages_.push( mesg.value() );
-      /* not what the tests expect. in flight as soon as pushed */
-      /* sequence_numbers_in_flight_ += mesg->sequence_length(); */
-    }
-    if ( !timer_.started() ) {
-      timer_.start();
-    }
+  if ( !srtt8_.has_value() ) {
+    srtt8_ = rtt_ms << 3;
+    rttvar4_ = rtt_ms << 1; // RTTVAR = R / 2
+    return;
   }
-  return mesg;
+  // RTTVAR <- 3/4 RTTVAR + 1/4 |SRTT - R|, then SRTT <- 7/8 SRTT + 1/8 R
+  const uint64_t srtt = srtt8_.value() >> 3;
+  rttvar4_ = rttvar4_ - ( rttvar4_ >> 2 ) + ( srtt > rtt_ms ? srtt - rtt_ms : rtt_ms - srtt );
+  srtt8_ = srtt8_.value() - srtt + rtt_ms;
 }
 
-void TCPSender::push( Reader& outbound_stream )
+optional<uint64_t> RTTEstimator::srtt_ms() const
 {
-  TCPSenderMessage mesg;
-  if ( !window_size_ && ackno_ == next_seqno_ ) {
-    window_size_ = 1;
+  if ( !srtt8_.has_value() ) {
+    return {};
   }
-  uint16_t payload_size_tot = static_cast<uint16_t>( window_size_ - !syn_ ) < outbound_stream.bytes_buffered()
-                                ? static_cast<uint16_t>( window_size_ - !syn_ )
-                                : outbound_stream.bytes_buffered();
-  while ( payload_size_tot > 0 || !syn_ ) {
-    auto sv = outbound_stream.peek();
-    uint16_t payload_size
-      = payload_size_tot < TCPConfig::MAX_PAYLOAD_SIZE ? payload_size_tot : TCPConfig::MAX_PAYLOAD_SIZE;
-    std::string payload { sv.begin(), sv.begin() + payload_size };
-    outbound_stream.pop( payload_size );
-    if ( outbound_stream.is_finished() && window_size_ > payload_size + !syn_ ) {
-      fin_ = true;
-    }
-    if ( !syn_ ) {
-      mesg = { isn_, true, payload, fin_ };
-      syn_ = true;
-    } else {
-      mesg = { next_seqno_, false, payload, fin_ };
-    }
-    next_seqno_ = next_seqno_ + mesg.sequence_length();
-    sequence_numbers_in_flight_ += mesg.sequence_length();
-    window_size_ -= mesg.sequence_length();
-    sender_messages_.push_back( mesg );
-    payload_size_tot -= payload_size;
-  }
-  if ( outbound_stream.is_finished() && window_size_ && !fin_ ) {
-    mesg = { next_seqno_, !syn_, {}, true };
-    sender_messages_.push_back( mesg );
-    next_seqno_ = next_seqno_ + mesg.sequence_length();
-    fin_ = true;
-    sequence_numbers_in_flight_ += mesg.sequence_length();
-  }
-}
-
-TCPSenderMessage TCPSender::send_empty_message() const
-{
-  return TCPSenderMessage { Wrap32( next_seqno_ ), false, {}, false };
+  return srtt8_.value() >> 3;
 }
 
-void TCPSender::receive( const TCPReceiverMessage& msg )
+optional<uint64_t> RTTEstimator::rttvar_ms() const
 {
-  if ( msg.ackno.has_value() && ackno_.unwrap( isn_, checkpoint_ ) <= msg.ackno->unwrap( isn_, checkpoint_ )
-       && msg.ackno->unwrap( isn_, checkpoint_ ) <= next_seqno_.unwrap( isn_, checkpoint_ ) ) {
-    ackno_ = msg.ackno.value();
-    window_size_ = msg.window_size;
-    window_size_ -= next_seqno_.unwrap( isn_, checkpoint_ ) - ackno_.unwrap( isn_, checkpoint_ );
-    if ( window_size_ < 1 ) {
-      window_size_ = 0;
-      nonzero_window_size_ = false;
-    } else {
-      nonzero_window_size_ = true;
-    }
-    bool popped {};
-    while ( !outstanding_messages_.empty() ) {
-      if ( ackno_.unwrap( isn_, checkpoint_ ) >= checkpoint_ + outstanding_messages_.front().sequence_length() ) {
-        checkpoint_ += outstanding_messages_.front().sequence_length();
-        sequence_numbers_in_flight_ -= outstanding_messages_.front().sequence_length();
-        outstanding_messages_.pop();
-        popped = true;
-      } else {
-        break;
-      }
-    }
-    timer_.set_RTO( initial_RTO_ms_ );
-    if ( !outstanding_messages_.empty() && popped ) { // ack new data, sending data
-      timer_.start();                                 // that is, restart
-      consecutive_retransmissions_ = 0;
-    } else if ( outstanding_messages_.empty() ) { // all data sent
-      timer_.reset();
-      consecutive_retransmissions_ = 0;
-    } // do nothing when no data is newly acked
-  } else if ( !msg.ackno.has_value() && !syn_ ) {
-    window_size_ = msg.window_size;
+  if ( !srtt8_.has_value() ) {
+    return {};
   }
+  return rttvar4_ >> 2;
 }
 
-void TCPSender::tick( const size_t ms_since_last_tick )
+optional<uint64_t> RTTEstimator::RTO_ms() const
 {
-  if ( timer_.started() ) {
-    timer_.add( ms_since_last_tick );
-    if ( timer_.expired() ) {
-      sender_messages_.push_front( outstanding_messages_.front() );
-      if ( nonzero_window_size_ ) {
-        consecutive_retransmissions_++;
-        timer_.double_RTO();
-      }
-      timer_.reset();
-    }
+  if ( !srtt8_.has_value() ) {
+    return {};
   }
+  // The clock granularity G is one millisecond
+  return clamp( ( srtt8_.value() >> 3 ) + max<uint64_t>( rttvar4_, 1 ), min_RTO_ms_, max_RTO_ms_ );
 }
+
+template class BasicTCPSender<DefaultSenderPolicy>;
+template class BasicTCPSender<RenoSenderPolicy>;
@@ -1,22 +1,34 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
+#include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
+#include "timing_wheel.hh"
 #include "wrapping_integers.hh"
+#include <algorithm>
 #include <cstdint>
 #include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
 #include <sys/types.h>
 
 class Timer
 {
 private:
+  uint64_t base_RTO_ms_; // RTO before any backoff
   uint64_t RTO_ms_;
+  uint64_t max_RTO_ms_ { UINT64_MAX };
   uint64_t ms_ {};
   bool started_ {};
 
 public:
-  explicit Timer( uint64_t RTO_ms ) : RTO_ms_( RTO_ms ) {}
+  explicit Timer( uint64_t RTO_ms ) : base_RTO_ms_( RTO_ms ), RTO_ms_( RTO_ms ) {}
   void start()
   {
     ms_ = 0;
@@ -25,38 +37,323 @@ public:
   bool expired() const { return ms_ >= RTO_ms_; }
   bool started() const { return started_; }
   void reset() { started_ = false; }
-  void set_RTO( uint64_t new_RTO ) { RTO_ms_ = new_RTO; }
-  void double_RTO() { RTO_ms_ <<= 1; }
+  void set_base_RTO( uint64_t new_RTO ) { base_RTO_ms_ = new_RTO; }
+  void set_max_RTO( uint64_t max_RTO ) { max_RTO_ms_ = max_RTO; }
+  void restore_RTO() { RTO_ms_ = base_RTO_ms_; } // undo the backoff
+  void double_RTO() { RTO_ms_ = std::min( RTO_ms_ << 1, max_RTO_ms_ ); }
   void add( uint64_t ms_to_add ) { ms_ += ms_to_add; }
+  uint64_t RTO_ms() const { return RTO_ms_; }
+  uint64_t remaining_ms() const { return started_ && ms_ < RTO_ms_ ? RTO_ms_ - ms_ : RTO_ms_; }
 };
 
-class TCPSender
+/*
+ * Smoothed RTT and RTT variance, and the retransmission timeout they give (RFC 6298). Like
+ * Jacobson's original, SRTT is kept scaled by 8 and RTTVAR by 4, so the 1/8 and 1/4 gains are shifts.
+ */
+class RTTEstimator
 {
+private:
+  uint64_t min_RTO_ms_;
+  uint64_t max_RTO_ms_;
+  std::optional<uint64_t> srtt8_ {}; // 8 * SRTT; empty until the first sample
+  uint64_t rttvar4_ {};              // 4 * RTTVAR
+
+public:
+  RTTEstimator( uint64_t min_RTO_ms, uint64_t max_RTO_ms ) : min_RTO_ms_( min_RTO_ms ), max_RTO_ms_( max_RTO_ms ) {}
+  void sample( uint64_t rtt_ms );
+  std::optional<uint64_t> srtt_ms() const;
+  std::optional<uint64_t> rttvar_ms() const;
+  std::optional<uint64_t> RTO_ms() const; // SRTT + max(G, 4 * RTTVAR), clamped to [min, max]
+};
+
+/*
+ * Compile-time choices for a BasicTCPSender. The default leaves everything to the TCPConfig at
+ * run time. A policy for a fixed deployment profile derives from it and overrides what it pins
+ * down: a concrete congestion controller is held by value and called without virtual dispatch,
+ * and machinery switched off here stays off whatever the config says, so its checks fold away.
+ */
+struct DefaultSenderPolicy
+{
+  using CongestionControl = ::CongestionControl; // Abstract: picked by TCPConfig::congestion_control
+  using RetransmissionTimer = Timer;
+  static constexpr std::optional<uint16_t> MSS {}; // Overrides TCPConfig::mss when set
+
+  // Loss recovery: how much the sender makes of each ACK beyond its ackno
+  static constexpr bool SACK = true;     // Use SACK blocks to find the holes (RFC 6675)
+  static constexpr bool RACK_TLP = true; // Allow TCPConfig::rack_tlp
+  static constexpr bool FRTO = true;     // Allow TCPConfig::frto
+
+  static constexpr bool ECN = true;         // Allow TCPConfig::ecn
+  static constexpr bool PACING = true;      // Allow TCPConfig::pacing
+  static constexpr bool MTU_PROBING = true; // Allow TCPConfig::mtu_probing
+};
+
+/* A plain Reno sender: duplicate ACKs, SACK and the RTO, with nothing chosen at run time */
+struct RenoSenderPolicy : DefaultSenderPolicy
+{
+  using CongestionControl = RenoCongestionControl;
+  static constexpr bool RACK_TLP = false;
+  static constexpr bool FRTO = false;
+  static constexpr bool ECN = false;
+  static constexpr bool PACING = false;
+  static constexpr bool MTU_PROBING = false;
+};
+
+/*
+ * Holds a sender's congestion controller, by value when the policy names a concrete one, or
+ * through a pointer (empty for CongestionControlAlgorithm::NONE) when it is chosen at run time.
+ */
+template<typename CC>
+class CongestionControlHolder
+{
+  CC cc_;
+
+public:
+  CongestionControlHolder( CongestionControlAlgorithm /* chosen by the policy */, uint64_t mss ) : cc_( mss ) {}
+  explicit operator bool() const { return true; }
+  CC* operator->() { return &cc_; }
+  const CC* operator->() const { return &cc_; }
+  const CC* get() const { return &cc_; }
+};
+
+template<>
+class CongestionControlHolder<CongestionControl>
+{
+  std::unique_ptr<CongestionControl> cc_;
+
+public:
+  CongestionControlHolder( CongestionControlAlgorithm algorithm, uint64_t mss )
+    : cc_( make_congestion_control( algorithm, mss ) )
+  {}
+  explicit operator bool() const { return cc_ != nullptr; }
+  CongestionControl* operator->() { return cc_.get(); }
+  const CongestionControl* operator->() const { return cc_.get(); }
+  const CongestionControl* get() const { return cc_.get(); }
+};
+
+template<typename Policy>
+class BasicTCPSender
+{
+  // A segment in the retransmission queue, with the delivery-rate sampling state
+  // (draft-cheng-iccrg-delivery-rate-estimation) captured when it was last sent
+  struct OutstandingSegment
+  {
+    uint64_t seqno {}; // Absolute seqno of the segment
+    TCPSenderMessage message {};
+    uint64_t transmissions {};
+    uint64_t sent_ms {};       // When it was last (re)transmitted
+    uint64_t delivered {};     // delivered_ at that time
+    uint64_t delivered_ms {};  // delivered_ms_ at that time
+    uint64_t first_sent_ms {}; // first_sent_ms_ at that time
+    bool app_limited {};       // Was the sender app-limited at that time?
+    bool sacked {};            // Reported held by the receiver in a SACK block
+    bool retransmitted {};     // Already resent during the current recovery
+    bool queued {};            // Waiting in ready_seqnos_ to be (re)sent
+    bool mtu_probe {};         // Sent larger than mss_ to test the path MTU
+  };
+
+  static constexpr uint64_t DUP_ACK_THRESHOLD = 3; // Duplicate ACKs that trigger fast retransmit (RFC 5681)
+  static constexpr uint64_t PACING_GAIN = 2;       // Pace at this many cwnds per SRTT without a controller rate
+  static constexpr uint64_t MTU_PROBE_PRECISION = 32;         // Stop searching once the MSS is this close
+  static constexpr uint64_t MTU_REPROBE_INTERVAL_MS = 600000; // Then search again this often (RFC 4821)
+  static constexpr uint64_t TLP_MAX_ACK_DELAY_MS = 200;       // Allowance for a delayed ACK of a lone segment
+  static constexpr uint64_t TLP_DEFAULT_PTO_MS = 1000;        // Probe timeout before there is an SRTT
+
+  // Sequence numbers are kept absolute (64-bit) and only wrapped when a message is built
   Wrap32 isn_;
-  uint64_t initial_RTO_ms_;
-  std::deque<TCPSenderMessage> sender_messages_ {};
-  std::queue<TCPSenderMessage> outstanding_messages_ {};
-  Wrap32 ackno_;
-  Wrap32 next_seqno_;
-  uint64_t checkpoint_ {};
+  uint64_t configured_mss_ { TCPConfig::MAX_PAYLOAD_SIZE };
+  uint64_t max_mss_ { TCPConfig::MAX_PAYLOAD_SIZE }; // configured_mss_, or less if the peer advertised less
+  uint64_t mss_ { TCPConfig::MAX_PAYLOAD_SIZE };     // max_mss_, or less while probing the path MTU
+  bool super_segments_ {};
+
+  // Packetization-layer path MTU discovery (RFC 4821): a binary search between mss_, which is
+  // known to get through, and mtu_search_high_, using single oversized probe segments
+  bool mtu_probing_ {};
+  bool mtu_probe_in_flight_ {};
+  uint64_t mtu_search_high_ {};
+  uint64_t next_mtu_probe_ms_ {}; // When to search again after converging
+
+  std::deque<uint64_t> ready_seqnos_ {}; // Outstanding segments waiting to be (re)transmitted by maybe_send()
+  std::deque<OutstandingSegment> outstanding_messages_ {};
+  uint64_t ackno_ {};      // Absolute ackno of the peer's receiver
+  uint64_t next_seqno_ {}; // Absolute seqno of the next byte to be pushed
+  uint64_t sent_seqno_ {}; // Absolute seqno of the next byte never transmitted; the rest were pushed but held back
   uint64_t consecutive_retransmissions_ {};
   uint64_t sequence_numbers_in_flight_ {};
-  uint16_t window_size_ { 1 };
+  uint16_t window_size_ { 1 }; // The peer's advertised window
   bool syn_ {};
   bool fin_ {};
   bool nonzero_window_size_ { true };
-  Timer timer_;
+  typename Policy::RetransmissionTimer timer_;
+  RTTEstimator rtt_estimator_ { TCPConfig::MIN_TIMEOUT_DFLT, TCPConfig::MAX_TIMEOUT_DFLT };
+  bool adaptive_RTO_ {}; // Drive timer_ from rtt_estimator_ rather than the initial RTO
+  uint64_t time_ms_ {};                      // Sender clock, advanced by tick() and sent as TSval
+  std::optional<uint64_t> rtt_sample_ms_ {}; // Latest RTT sample taken from an echoed TSval
+  CongestionControlHolder<typename Policy::CongestionControl> congestion_control_;
+
+  // Fast retransmit and recovery: SACK-based (RFC 6675) when the receiver reports SACK blocks,
+  // NewReno (RFC 6582) otherwise
+  uint64_t duplicate_acks_ {};
+  uint64_t recover_ {};     // next_seqno_ at the last loss event; recovery ends once it is acknowledged
+  bool in_recovery_ {};
+
+  // The SACK scoreboard's totals, kept up to date as segments are SACKed, marked lost or resent
+  // and acknowledged, so pipe() needn't walk the outstanding queue. Per RFC 6675 a segment is
+  // lost once DUP_ACK_THRESHOLD segments above it were SACKed; those are exactly the ones below
+  // lost_end_, which only moves up.
+  uint64_t sacked_segments_ {};       // Outstanding segments SACKed
+  uint64_t sacked_bytes_ {};          // and their sequence length
+  uint64_t lost_end_ {};              // Unsacked segments below this are lost
+  uint64_t sacked_below_lost_end_ {}; // SACKed segments below lost_end_
+  uint64_t lost_bytes_ {};            // Sequence length of the lost, unsacked segments
+  uint64_t retransmitted_bytes_ {};   // Sequence length of the unsacked segments resent this recovery
+  uint64_t high_rxt_ {};              // retransmit_holes() has considered every segment below this
+
+  // RACK-TLP (RFC 8985): a segment is lost once one sent after it has been delivered and a
+  // reordering window has passed; a probe after about two SRTTs of silence draws out an ACK
+  // that lets this detect a tail loss well before the RTO
+  bool rack_tlp_ {};
+  std::optional<uint64_t> rack_xmit_ms_ {}; // Send time of the most recently sent segment delivered
+  uint64_t rack_end_ {};                    // and the end of that segment,
+  uint64_t rack_rtt_ms_ {};                 // and the RTT it measured
+  std::optional<uint64_t> min_rtt_ms_ {};
+  std::optional<uint64_t> rack_timer_ms_ {}; // When the reordering window closes on a suspect segment
+  std::optional<uint64_t> tlp_timer_ms_ {};  // When to send a tail loss probe
+  std::optional<uint64_t> tlp_end_ {};       // next_seqno_ when the outstanding probe was sent,
+  bool tlp_retransmitted_ {};                // and whether it resent data rather than sending new data
+  bool tlp_unpaced_ {};                      // The probe is queued, to go out ahead of pacing
+
+  // Spurious timeout detection: after a first timeout, two ACKs of new data below frto_recover_
+  // (F-RTO, RFC 5682), or an echoed timestamp older than the retransmission (Eifel, RFC 3522),
+  // show that the original segment was only delayed, so the timeout's response is undone (RFC 4015)
+  bool frto_ {};
+  std::optional<uint64_t> frto_recover_ {}; // next_seqno_ at the timeout, while its ACKs are examined
+  uint64_t frto_acks_ {};                   // ACKs of new data since the timeout
+  uint64_t rto_sent_ms_ {};                 // When the timeout's retransmission was queued
+  uint64_t spurious_rtos_ {};
+
+  // ECN (RFC 3168): new data goes out ECN-capable, and the first ECE of each window counts as
+  // congestion; the next segment of new data carries CWR to say so
+  bool ecn_ {};
+  uint64_t ecn_recover_ {}; // next_seqno_ at the last reduction; ECE is ignored until it is acknowledged
+  bool cwr_pending_ {};
+
+  // Writability: the application should only write while the unsent backlog, in the outbound
+  // stream and held back here, is below this (like Linux's TCP_NOTSENT_LOWAT)
+  std::optional<uint64_t> notsent_lowat_ {};
+
+  // Small-segment coalescing: under Nagle or cork, push() leaves a short tail in the stream
+  // rather than send it, unless the stream is closed or flush() covered it
+  Coalescing coalescing_ { Coalescing::NODELAY };
+  uint64_t flush_end_ {}; // Stream index through which short segments may go out
+
+  // Pacing: maybe_send() holds segments back until the sender clock reaches next_send_us_
+  bool pacing_ {};
+  uint64_t next_send_us_ {};
+
+  // Delivery rate estimation
+  uint64_t delivered_ {};     // Sequence numbers cumulatively acknowledged
+  uint64_t delivered_ms_ {};  // When delivered_ last changed
+  uint64_t first_sent_ms_ {}; // Send time of the segment that started the current sampling interval
+  uint64_t app_limited_ {};   // Nonzero while samples are app-limited: delivered_ at which that ends
+
+  // A TimingWheel shared with other senders, once attach()ed: the clock follows the wheel's, and a
+  // single wheel timer, under the owner's tag, stands for the earliest deadline (RTO, RACK, TLP, pacing)
+  std::optional<std::reference_wrapper<TimingWheel>> wheel_ {};
+  uint64_t wheel_tag_ {};
+  uint64_t wheel_epoch_ms_ {}; // The wheel's time when time_ms_ was zero
+  std::optional<TimingWheel::TimerId> wakeup_ {};
+  std::optional<uint64_t> wakeup_ms_ {}; // The deadline wakeup_ was armed for
+
+  // Features the policy may have compiled out
+  bool mtu_probing() const { return Policy::MTU_PROBING && mtu_probing_; }
+  bool rack_tlp() const { return Policy::RACK_TLP && rack_tlp_; }
+  bool frto() const { return Policy::FRTO && frto_; }
+  bool ecn() const { return Policy::ECN && ecn_; }
+  bool pacing() const { return Policy::PACING && pacing_; }
+
+  std::deque<OutstandingSegment>::iterator outstanding_at_or_after( uint64_t seqno );
+  OutstandingSegment* find_outstanding( uint64_t seqno );
+  void retransmit_first_outstanding();
+  void set_mss( uint64_t mss );
+  bool hold_small_segment( uint64_t payload_size, const Reader& outbound_stream ) const;
+  std::optional<uint64_t> mtu_probe_size();
+  bool mtu_probe_lost();
+  void update_scoreboard( const std::vector<SACKBlock>& blocks );
+  void mark_sacked( OutstandingSegment& seg );
+  void mark_retransmitted( OutstandingSegment& seg );
+  void advance_lost_end();
+  void forget( const OutstandingSegment& seg ); // Drop a segment leaving the queue from the scoreboard
+  void queue_first( OutstandingSegment& seg );  // Put a segment at the head of ready_seqnos_
+  uint64_t pipe() const;
+  void retransmit_holes( bool include_first );
+  void trim_partially_acked();
+  void enter_recovery();
+  void rack_update( const OutstandingSegment& seg );
+  void rack_detect_loss();
+  void arm_tail_loss_probe();
+  void send_tail_loss_probe();
+  const TCPSenderMessage* next_message(); // Stamp and account for the next segment to send, if any
+  void detect_spurious_rto( const TCPReceiverMessage& msg, bool new_data, bool duplicate );
+  std::optional<DeliveryRateSample> pop_acked_segments( std::optional<uint64_t>& rtt_ms );
+  void catch_up();     // With a shared wheel: tick() up to the wheel's time
+  void rearm_wakeup(); // With a shared wheel: move the wheel timer to the earliest deadline
 
 public:
   /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
-  TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn );
+  BasicTCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn, const FourTuple& tuple = {} );
+
+  /* Construct TCP sender from a connection's configuration */
+  explicit BasicTCPSender( const TCPConfig& config );
 
   /* Push bytes from the outbound stream */
   void push( Reader& outbound_stream );
 
+  /* Push everything in the outbound stream now, without holding back a short final segment */
+  void flush( Reader& outbound_stream );
+
   /* Send a TCPSenderMessage if needed (or empty optional otherwise) */
   std::optional<TCPSenderMessage> maybe_send();
 
+  /* Fill `messages` with as many of the segments ready to send as fit; returns how many */
+  size_t maybe_send_batch( std::span<TCPSenderMessage> messages );
+
+  /*
+   * Hand every segment ready to send to `callback`, in order, and return how many there were.
+   * Each is passed by reference to the copy held for retransmission, so nothing is copied; the
+   * reference is only good until the callback returns, and the callback must not call back in.
+   */
+  template<typename Callback>
+  size_t transmit( Callback&& callback )
+  {
+    catch_up();
+    size_t count = 0;
+    for ( const TCPSenderMessage* mesg = next_message(); mesg != nullptr; mesg = next_message() ) {
+      callback( *mesg );
+      count++;
+    }
+    return count;
+  }
+
+  /*
+   * With pacing on, when maybe_send() will next release a queued segment, in the milliseconds
+   * counted by tick(). Empty when nothing is queued; otherwise no earlier than the current time.
+   */
+  std::optional<uint64_t> next_send_time() const;
+
+  /*
+   * How much of the outbound data has never been transmitted: bytes still in the stream plus
+   * sequence numbers pushed into segments that maybe_send() hasn't released yet
+   */
+  uint64_t unsent_bytes( const Reader& outbound_stream ) const;
+
+  /*
+   * Should the application write more? Without a notsent_lowat, always (the stream's capacity is
+   * the only limit); with one, only while the unsent backlog is below it. Keeping the backlog small means fresh
+   * writes wait behind little stale data, without shrinking the window.
+   */
+  bool writable( const Reader& outbound_stream ) const;
+
   /* Generate an empty TCPSenderMessage */
   TCPSenderMessage send_empty_message() const;
 
@@ -66,7 +363,38 @@ public:
   /* Time has passed by the given # of milliseconds since the last time the tick() method was called. */
   void tick( uint64_t ms_since_last_tick );
 
+  /*
+   * Keep this sender's timers on a TimingWheel shared by many senders, under `tag`. From then on
+   * the sender's clock is the wheel's: rather than tick() every sender, the wheel's owner advances
+   * the wheel once and calls wake() on just the senders whose tags come back.
+   */
+  void attach( TimingWheel& wheel, uint64_t tag );
+
+  /* Catch up with the shared wheel's clock, handling whatever deadlines have passed */
+  void wake();
+
   /* Accessors for use in testing */
-  uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
-  uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t sequence_numbers_in_flight() const;   // How many sequence numbers are outstanding?
+  uint64_t consecutive_retransmissions() const;  // How many consecutive *re*transmissions have happened?
+  uint64_t spurious_rtos() const { return spurious_rtos_; } // How many timeouts turned out spurious?
+  std::optional<uint64_t> rtt_sample_ms() const; // Most recent RTT measured through the timestamps option
+  uint64_t congestion_window() const;            // Congestion window (unlimited without congestion control)
+  std::optional<uint64_t> srtt_ms() const;       // Smoothed RTT, once there is a sample
+  std::optional<uint64_t> rttvar_ms() const;     // RTT variance, once there is a sample
+  uint64_t rto_ms() const;                       // Current retransmission timeout, backoff included
+  uint64_t mss() const { return mss_; }          // Maximum segment size in use
+  uint64_t max_payload_size() const;             // Largest payload push() puts in one segment
+  std::optional<uint64_t> pacing_rate() const;   // Bytes per second, or empty if unpaced
+  bool syn_sent() const { return syn_; }         // Has the SYN gone into a segment?
+  bool syn_acked() const { return ackno_ > 0; }  // Has the peer acknowledged it?
+  bool fin_sent() const { return fin_; }         // Has the FIN gone into a segment?
+  const CongestionControl* congestion_control() const { return congestion_control_.get(); }
 };
+
+#include "tcp_sender.tpp"
+
+// The shipped policies are instantiated once, in tcp_sender.cc
+extern template class BasicTCPSender<DefaultSenderPolicy>;
+extern template class BasicTCPSender<RenoSenderPolicy>;
+
+using TCPSender = BasicTCPSender<DefaultSenderPolicy>;
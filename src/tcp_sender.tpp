@@ -0,0 +1,970 @@
+#pragma once
+
+// Member definitions of BasicTCPSender, included at the end of tcp_sender.hh so that any policy can
+// instantiate the template. The shipped policies are instantiated once, in tcp_sender.cc.
+
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_sender_message.hh"
+#include "wrapping_integers.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+/* TCPSender constructor (uses a keyed, clock-driven ISN if none given) */
+template<typename Policy>
+BasicTCPSender<Policy>::BasicTCPSender( uint64_t initial_RTO_ms,
+                                        std::optional<Wrap32> fixed_isn,
+                                        const FourTuple& tuple )
+  : isn_( fixed_isn.has_value() ? fixed_isn.value()
+                                : Wrap32 { generate_isn(
+                                    tuple.local_address, tuple.local_port, tuple.remote_address, tuple.remote_port ) } )
+  , timer_( initial_RTO_ms )
+  , congestion_control_( CongestionControlAlgorithm::NONE, TCPConfig::MAX_PAYLOAD_SIZE )
+{}
+
+template<typename Policy>
+BasicTCPSender<Policy>::BasicTCPSender( const TCPConfig& config )
+  : BasicTCPSender( config.rt_timeout, config.fixed_isn, config.four_tuple )
+{
+  const uint16_t mss = Policy::MSS.value_or( config.mss );
+  configured_mss_ = mss;
+  max_mss_ = mss;
+  mss_ = mss;
+  super_segments_ = config.super_segments;
+  mtu_probing_ = config.mtu_probing && !config.super_segments; // a probe must not be split
+  if ( mtu_probing() ) {
+    mss_ = std::min<uint64_t>( mss, TCPConfig::MAX_PAYLOAD_SIZE );
+    mtu_search_high_ = mss;
+  }
+  congestion_control_ = CongestionControlHolder<typename Policy::CongestionControl>( config.congestion_control, mss_ );
+  rtt_estimator_ = RTTEstimator { config.rt_timeout_min, config.rt_timeout_max };
+  adaptive_RTO_ = config.adaptive_rt_timeout;
+  pacing_ = config.pacing;
+  rack_tlp_ = config.rack_tlp;
+  frto_ = config.frto;
+  ecn_ = config.ecn || config.congestion_control == CongestionControlAlgorithm::DCTCP
+         || std::is_same_v<typename Policy::CongestionControl, DCTCPCongestionControl>;
+  notsent_lowat_ = config.notsent_lowat;
+  coalescing_ = config.coalescing;
+  if ( adaptive_RTO_ ) {
+    timer_.set_max_RTO( config.rt_timeout_max );
+  }
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::sequence_numbers_in_flight() const
+{
+  return sequence_numbers_in_flight_;
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::consecutive_retransmissions() const
+{
+  return consecutive_retransmissions_;
+}
+
+template<typename Policy>
+std::optional<uint64_t> BasicTCPSender<Policy>::rtt_sample_ms() const
+{
+  return rtt_sample_ms_;
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::congestion_window() const
+{
+  return congestion_control_ ? congestion_control_->cwnd() : UINT64_MAX;
+}
+
+template<typename Policy>
+std::optional<uint64_t> BasicTCPSender<Policy>::srtt_ms() const
+{
+  return rtt_estimator_.srtt_ms();
+}
+
+template<typename Policy>
+std::optional<uint64_t> BasicTCPSender<Policy>::rttvar_ms() const
+{
+  return rtt_estimator_.rttvar_ms();
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::rto_ms() const
+{
+  return timer_.RTO_ms();
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::max_payload_size() const
+{
+  // A super segment is a whole number of MSS, so it splits into full-sized segments
+  if ( super_segments_ ) {
+    return std::max( mss_, TCPConfig::MAX_SUPER_SEGMENT_SIZE / mss_ * mss_ );
+  }
+  return mtu_probing() ? max_mss_ : mss_; // an MTU probe is larger than mss_
+}
+
+template<typename Policy>
+std::optional<uint64_t> BasicTCPSender<Policy>::pacing_rate() const
+{
+  if ( !pacing() ) {
+    return {};
+  }
+  if ( congestion_control_ && congestion_control_->pacing_rate().has_value() ) {
+    return congestion_control_->pacing_rate();
+  }
+  // Otherwise a multiple of cwnd / SRTT, so pacing smooths the bursts without holding back growth
+  const std::optional<uint64_t> srtt = srtt_ms();
+  if ( !congestion_control_ || !srtt.has_value() ) {
+    return {};
+  }
+  return PACING_GAIN * congestion_window() * 1000 / std::max<uint64_t>( srtt.value(), 1 );
+}
+
+template<typename Policy>
+std::optional<uint64_t> BasicTCPSender<Policy>::next_send_time() const
+{
+  if ( ready_seqnos_.empty() ) {
+    return {};
+  }
+  return std::max( time_ms_, next_send_us_ / 1000 );
+}
+
+template<typename Policy>
+auto BasicTCPSender<Policy>::outstanding_at_or_after( uint64_t seqno ) -> std::deque<OutstandingSegment>::iterator
+{
+  return std::lower_bound( outstanding_messages_.begin(),
+                      outstanding_messages_.end(),
+                      seqno,
+                      []( const OutstandingSegment& seg, uint64_t s ) { return seg.seqno < s; } );
+}
+
+template<typename Policy>
+auto BasicTCPSender<Policy>::find_outstanding( uint64_t seqno ) -> OutstandingSegment*
+{
+  auto it = outstanding_at_or_after( seqno );
+  return it != outstanding_messages_.end() && it->seqno == seqno ? &*it : nullptr;
+}
+
+template<typename Policy>
+const TCPSenderMessage* BasicTCPSender<Policy>::next_message()
+{
+  catch_up();
+  if ( next_send_us_ / 1000 > time_ms_ && !tlp_unpaced_ ) {
+    return nullptr; // paced: the next release slot is in a later millisecond
+  }
+  while ( !ready_seqnos_.empty() ) {
+    OutstandingSegment* seg = find_outstanding( ready_seqnos_.front() );
+    ready_seqnos_.pop_front();
+    if ( seg == nullptr || seg->sacked || !seg->queued ) {
+      continue; // acknowledged (or SACKed) while it waited to be retransmitted, or already resent
+    }
+    seg->queued = false;
+    tlp_unpaced_ = false;
+    // Segments go out in order (a retransmission resends the oldest), so nothing sent is
+    // in flight exactly when the oldest outstanding segment hasn't been sent yet
+    if ( outstanding_messages_.front().transmissions == 0 ) {
+      first_sent_ms_ = time_ms_;
+      delivered_ms_ = time_ms_;
+    }
+    seg->transmissions++;
+    seg->sent_ms = time_ms_;
+    if ( seg->transmissions == 1 ) {
+      sent_seqno_ = std::max( sent_seqno_, seg->seqno + seg->message.sequence_length() );
+      arm_tail_loss_probe();
+    }
+    seg->delivered = delivered_;
+    seg->delivered_ms = delivered_ms_;
+    seg->first_sent_ms = first_sent_ms_;
+    seg->app_limited = app_limited_ != 0;
+    if ( !timer_.started() ) {
+      timer_.start();
+    }
+    const std::optional<uint64_t> rate = pacing_rate();
+    if ( rate.has_value() && rate.value() > 0 ) {
+      // Release slots are kept in microseconds, so at rates above one segment per millisecond
+      // each tick lets out just the segments whose slots fall within it
+      next_send_us_
+        = std::max( next_send_us_, time_ms_ * 1000 ) + seg->message.sequence_length() * 1000000 / rate.value();
+    }
+    // Stamped in place: the copy kept for retransmission is the one handed out
+    TCPSenderMessage& mesg = seg->message;
+    mesg.TSval = static_cast<uint32_t>( time_ms_ );
+    mesg.ECN = IPv4Header::ECN_NOT_ECT;
+    mesg.CWR = false;
+    if ( ecn() && !mesg.payload.empty() && seg->transmissions == 1 ) {
+      // Retransmissions are never ECN-capable (RFC 3168 section 6.1.5)
+      mesg.ECN = IPv4Header::ECN_ECT0;
+      mesg.CWR = std::exchange( cwr_pending_, false );
+    }
+    rearm_wakeup();
+    return &mesg;
+  }
+  return nullptr;
+}
+
+template<typename Policy>
+std::optional<TCPSenderMessage> BasicTCPSender<Policy>::maybe_send()
+{
+  const TCPSenderMessage* mesg = next_message();
+  if ( mesg == nullptr ) {
+    return {};
+  }
+  return *mesg;
+}
+
+template<typename Policy>
+size_t BasicTCPSender<Policy>::maybe_send_batch( std::span<TCPSenderMessage> messages )
+{
+  size_t count = 0;
+  const TCPSenderMessage* mesg = nullptr;
+  while ( count < messages.size() && ( mesg = next_message() ) != nullptr ) {
+    messages[count++] = *mesg;
+  }
+  return count;
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::retransmit_first_outstanding()
+{
+  if ( !outstanding_messages_.empty() ) {
+    queue_first( outstanding_messages_.front() );
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::queue_first( OutstandingSegment& seg )
+{
+  // An earlier entry for the segment, if any, is skipped once this one has sent it
+  if ( ready_seqnos_.empty() || ready_seqnos_.front() != seg.seqno ) {
+    ready_seqnos_.push_front( seg.seqno );
+  }
+  seg.queued = true;
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::update_scoreboard( const std::vector<SACKBlock>& blocks )
+{
+  for ( const auto& block : blocks ) {
+    const uint64_t begin = block.begin.unwrap( isn_, ackno_ );
+    const uint64_t end = block.end.unwrap( isn_, ackno_ );
+    if ( begin < ackno_ || end > next_seqno_ || begin >= end ) {
+      continue; // stale or bogus
+    }
+    for ( auto it = outstanding_at_or_after( begin );
+          it != outstanding_messages_.end() && it->seqno + it->message.sequence_length() <= end;
+          ++it ) {
+      if ( rack_tlp() && !it->sacked ) {
+        rack_update( *it );
+      }
+      mark_sacked( *it );
+    }
+  }
+  advance_lost_end();
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::mark_sacked( OutstandingSegment& seg )
+{
+  if ( seg.sacked ) {
+    return;
+  }
+  const uint64_t length = seg.message.sequence_length();
+  seg.sacked = true;
+  sacked_segments_++;
+  sacked_bytes_ += length;
+  if ( seg.seqno < lost_end_ ) {
+    sacked_below_lost_end_++;
+    lost_bytes_ -= length;
+  }
+  if ( seg.retransmitted ) {
+    retransmitted_bytes_ -= length;
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::mark_retransmitted( OutstandingSegment& seg )
+{
+  if ( !seg.retransmitted && !seg.sacked ) {
+    retransmitted_bytes_ += seg.message.sequence_length();
+  }
+  seg.retransmitted = true;
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::advance_lost_end()
+{
+  // Each segment is passed over once: SACKs only ever add to the count above a segment
+  for ( auto it = outstanding_at_or_after( lost_end_ ); it != outstanding_messages_.end(); ++it ) {
+    if ( sacked_segments_ - sacked_below_lost_end_ - it->sacked < DUP_ACK_THRESHOLD ) {
+      break;
+    }
+    if ( it->sacked ) {
+      sacked_below_lost_end_++;
+    } else {
+      lost_bytes_ += it->message.sequence_length();
+    }
+    lost_end_ = it->seqno + it->message.sequence_length();
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::forget( const OutstandingSegment& seg )
+{
+  // Segments leave from the bottom, so the count of SACKed segments above the rest is unchanged
+  const uint64_t length = seg.message.sequence_length();
+  if ( seg.sacked ) {
+    sacked_segments_--;
+    sacked_bytes_ -= length;
+    sacked_below_lost_end_ -= seg.seqno < lost_end_;
+    return;
+  }
+  lost_bytes_ -= seg.seqno < lost_end_ ? length : 0;
+  retransmitted_bytes_ -= seg.retransmitted ? length : 0;
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::pipe() const
+{
+  if ( !in_recovery_ ) {
+    return sequence_numbers_in_flight_;
+  }
+  // RFC 6675 SetPipe(): what isn't SACKed or lost, plus what was resent
+  return sequence_numbers_in_flight_ - sacked_bytes_ - lost_bytes_ + retransmitted_bytes_;
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::retransmit_holes( bool include_first )
+{
+  // RFC 6675 NextSeg(): resend lost, unSACKed segments from the lowest up while the pipe has room.
+  // The first outstanding segment goes regardless when include_first is set (on entering recovery
+  // and on a partial ACK), which without SACK information is exactly NewReno.
+  const uint64_t cwnd = congestion_window();
+  auto insert_at = ready_seqnos_.begin();
+  const auto resend = [&]( OutstandingSegment& seg ) {
+    if ( seg.sacked || seg.retransmitted ) {
+      return;
+    }
+    mark_retransmitted( seg );
+    if ( !seg.queued ) {
+      seg.queued = true;
+      insert_at = ready_seqnos_.insert( insert_at, seg.seqno ) + 1;
+    }
+  };
+  if ( include_first && !outstanding_messages_.empty() ) {
+    resend( outstanding_messages_.front() );
+  }
+  // Segments below high_rxt_ were resent already, or SACKed
+  for ( auto it = outstanding_at_or_after( high_rxt_ ); it != outstanding_messages_.end() && it->seqno < lost_end_;
+        ++it ) {
+    if ( pipe() >= cwnd ) {
+      break;
+    }
+    resend( *it );
+    high_rxt_ = it->seqno + it->message.sequence_length();
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::set_mss( uint64_t mss )
+{
+  mss_ = mss;
+  if ( congestion_control_ ) {
+    congestion_control_->set_mss( mss_ );
+  }
+}
+
+template<typename Policy>
+std::optional<uint64_t> BasicTCPSender<Policy>::mtu_probe_size()
+{
+  if ( !mtu_probing() || mtu_probe_in_flight_ || in_recovery_ ) {
+    return {};
+  }
+  if ( mtu_search_high_ < mss_ + MTU_PROBE_PRECISION ) {
+    if ( time_ms_ < next_mtu_probe_ms_ || max_mss_ < mss_ + MTU_PROBE_PRECISION ) {
+      return {};
+    }
+    mtu_search_high_ = max_mss_; // the path may have changed since the last search
+  }
+  return ( mss_ + mtu_search_high_ + 1 ) / 2;
+}
+
+template<typename Policy>
+bool BasicTCPSender<Policy>::mtu_probe_lost()
+{
+  if ( outstanding_messages_.empty() || !outstanding_messages_.front().mtu_probe ) {
+    return false;
+  }
+  // A lost probe says the path MTU is smaller, not that the path is congested: narrow the
+  // search and resend its data in segments known to fit
+  const OutstandingSegment probe = std::move( outstanding_messages_.front() );
+  forget( probe );
+  outstanding_messages_.pop_front();
+  mtu_probe_in_flight_ = false;
+  mtu_search_high_ = probe.message.payload.size() - 1;
+  next_mtu_probe_ms_ = time_ms_ + MTU_REPROBE_INTERVAL_MS;
+  erase( ready_seqnos_, probe.seqno );
+
+  const std::vector<TCPSenderMessage> pieces = probe.message.split( mss_ );
+  uint64_t seqno = probe.seqno + probe.message.sequence_length();
+  for ( auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece ) {
+    seqno -= piece->sequence_length();
+    OutstandingSegment seg = probe;
+    seg.seqno = seqno;
+    seg.message = *piece;
+    seg.mtu_probe = false;
+    seg.sacked = false;
+    seg.retransmitted = false;
+    seg.queued = true;
+    lost_bytes_ += seqno < lost_end_ ? seg.message.sequence_length() : 0;
+    outstanding_messages_.push_front( std::move( seg ) );
+    ready_seqnos_.push_front( seqno );
+  }
+  return true;
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::push( Reader& outbound_stream )
+{
+  catch_up();
+  TCPSenderMessage mesg;
+  const uint64_t in_flight = next_seqno_ - ackno_;
+  // A zero window is probed as if it were one byte wide while nothing is in flight
+  const uint64_t window = std::max<uint64_t>( window_size_, in_flight == 0 );
+  const uint64_t cwnd = congestion_window();
+  const uint64_t pipe_size = pipe();
+  uint64_t room = std::min( window > in_flight ? window - in_flight : 0, cwnd > pipe_size ? cwnd - pipe_size : 0 );
+  if ( room == 0 ) {
+    return;
+  }
+  uint64_t payload_size_tot = std::min( room - !syn_, outbound_stream.bytes_buffered() );
+  while ( payload_size_tot > 0 || !syn_ ) {
+    uint64_t payload_size = std::min( payload_size_tot, super_segments_ ? max_payload_size() : mss_ );
+    const std::optional<uint64_t> probe_size = syn_ && ackno_ > 0 ? mtu_probe_size() : std::optional<uint64_t> {};
+    const bool probe = probe_size.has_value() && payload_size_tot >= probe_size.value();
+    if ( probe ) {
+      payload_size = probe_size.value();
+      mtu_probe_in_flight_ = true;
+    }
+    if ( hold_small_segment( payload_size, outbound_stream ) ) {
+      if ( syn_ ) {
+        break;
+      }
+      payload_size = 0; // The SYN never waits: only its data does
+    }
+    const Buffer payload = outbound_stream.peek_buffer( payload_size ); // shares the stream's storage
+    outbound_stream.pop( payload_size );
+    if ( outbound_stream.is_finished() && room > payload_size + !syn_ ) {
+      fin_ = true;
+    }
+    mesg = { Wrap32::wrap( next_seqno_, isn_ ), !syn_, payload, fin_ };
+    syn_ = true;
+    ready_seqnos_.push_back( next_seqno_ );
+    outstanding_messages_.push_back( { next_seqno_, mesg } );
+    outstanding_messages_.back().mtu_probe = probe;
+    outstanding_messages_.back().queued = true;
+    next_seqno_ += mesg.sequence_length();
+    sequence_numbers_in_flight_ += mesg.sequence_length();
+    room -= mesg.sequence_length();
+    payload_size_tot -= payload_size;
+  }
+  if ( outbound_stream.is_finished() && room && !fin_ ) {
+    mesg = { Wrap32::wrap( next_seqno_, isn_ ), !syn_, {}, true };
+    fin_ = true;
+    ready_seqnos_.push_back( next_seqno_ );
+    outstanding_messages_.push_back( { next_seqno_, mesg } );
+    outstanding_messages_.back().queued = true;
+    next_seqno_ += mesg.sequence_length();
+    sequence_numbers_in_flight_ += mesg.sequence_length();
+    room -= mesg.sequence_length();
+  }
+  // Out of data with window to spare: rate samples taken until this flight is delivered
+  // measure the application, not the path
+  if ( room > 0 && outbound_stream.bytes_buffered() == 0 ) {
+    app_limited_ = std::max<uint64_t>( delivered_ + sequence_numbers_in_flight_, 1 );
+  }
+}
+
+template<typename Policy>
+bool BasicTCPSender<Policy>::hold_small_segment( uint64_t payload_size, const Reader& outbound_stream ) const
+{
+  // Only a segment that would take all the buffered data and still be short is worth holding
+  if ( coalescing_ == Coalescing::NODELAY || payload_size == 0 || payload_size >= mss_
+       || payload_size < outbound_stream.bytes_buffered() || outbound_stream.writer().is_closed()
+       || outbound_stream.bytes_popped() + payload_size <= flush_end_ ) {
+    return false;
+  }
+  return coalescing_ == Coalescing::CORK || next_seqno_ > ackno_;
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::flush( Reader& outbound_stream )
+{
+  flush_end_ = outbound_stream.bytes_popped() + outbound_stream.bytes_buffered();
+  push( outbound_stream );
+}
+
+template<typename Policy>
+uint64_t BasicTCPSender<Policy>::unsent_bytes( const Reader& outbound_stream ) const
+{
+  return outbound_stream.bytes_buffered() + next_seqno_ - sent_seqno_;
+}
+
+template<typename Policy>
+bool BasicTCPSender<Policy>::writable( const Reader& outbound_stream ) const
+{
+  return !notsent_lowat_.has_value() || unsent_bytes( outbound_stream ) < notsent_lowat_.value();
+}
+
+template<typename Policy>
+TCPSenderMessage BasicTCPSender<Policy>::send_empty_message() const
+{
+  // Stamped with the shared wheel's time, which this const method can't catch up to
+  const uint64_t now_ms = wheel_.has_value() ? wheel_->get().now_ms() - wheel_epoch_ms_ : time_ms_;
+  return TCPSenderMessage { Wrap32::wrap( next_seqno_, isn_ ), false, {}, false, static_cast<uint32_t>( now_ms ) };
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::receive( const TCPReceiverMessage& msg )
+{
+  catch_up();
+  if ( msg.MSS.has_value() && msg.MSS.value() > 0 ) {
+    // Never send more per segment than the peer's receiver accepts
+    max_mss_ = std::min<uint64_t>( configured_mss_, msg.MSS.value() );
+    mtu_search_high_ = std::min( mtu_search_high_, max_mss_ );
+    set_mss( mtu_probing() ? std::min( mss_, max_mss_ ) : max_mss_ );
+  }
+  if ( !msg.ackno.has_value() ) {
+    if ( !syn_ ) {
+      window_size_ = msg.window_size;
+    }
+    return;
+  }
+
+  // The only unwrap per ACK: everything else is already absolute
+  const uint64_t ackno = msg.ackno->unwrap( isn_, ackno_ );
+  if ( ackno < ackno_ || ackno > next_seqno_ ) {
+    return;
+  }
+  const uint64_t acked = ackno - ackno_;
+  ackno_ = ackno;
+  if ( msg.TSecr.has_value() ) {
+    rtt_sample_ms_ = static_cast<uint32_t>( time_ms_ ) - msg.TSecr.value();
+  }
+  // A duplicate ACK acknowledges nothing new and leaves the window alone while data is outstanding
+  const bool duplicate = acked == 0 && msg.window_size == window_size_ && sequence_numbers_in_flight_ > 0;
+  window_size_ = msg.window_size;
+  nonzero_window_size_ = msg.window_size > 0;
+
+  if ( Policy::SACK ) {
+    update_scoreboard( msg.SACK );
+  }
+
+  if ( duplicate && ++duplicate_acks_ == DUP_ACK_THRESHOLD && !in_recovery_ && ackno_ > recover_
+       && !mtu_probe_lost() ) {
+    // Fast retransmit: three duplicates mean the segment after ackno_ was most likely lost
+    enter_recovery();
+    retransmit_holes( true );
+  } else if ( duplicate && in_recovery_ ) {
+    retransmit_holes( false ); // new SACK information may reveal more losses
+  }
+
+  const size_t outstanding_before = outstanding_messages_.size();
+  if ( acked > 0 ) {
+    duplicate_acks_ = 0;
+    delivered_ += acked;
+    delivered_ms_ = time_ms_;
+    std::optional<uint64_t> rtt_ms {};
+    const std::optional<DeliveryRateSample> rate_sample = pop_acked_segments( rtt_ms );
+    // With timestamps every ACK of new data gives an unambiguous sample (RFC 7323); without them,
+    // Karn's rule leaves only segments that were never retransmitted
+    if ( msg.TSecr.has_value() ) {
+      rtt_ms = rtt_sample_ms_;
+    }
+    if ( rtt_ms.has_value() ) {
+      min_rtt_ms_ = std::min( min_rtt_ms_.value_or( rtt_ms.value() ), rtt_ms.value() );
+      rtt_estimator_.sample( rtt_ms.value() );
+      if ( adaptive_RTO_ ) {
+        timer_.set_base_RTO( rtt_estimator_.RTO_ms().value() );
+      }
+    }
+    if ( app_limited_ != 0 && delivered_ > app_limited_ ) {
+      app_limited_ = 0;
+    }
+    if ( in_recovery_ && ackno_ < recover_ ) {
+      // Partial ACK: the next hole was lost too, so resend it without waiting for more duplicates
+      retransmit_holes( true );
+    } else {
+      in_recovery_ = false;
+    }
+    if ( congestion_control_ ) {
+      congestion_control_->on_ack( { acked,
+                                     next_seqno_ - ackno_,
+                                     time_ms_,
+                                     msg.TSecr.has_value() ? rtt_sample_ms_ : std::optional<uint64_t> {},
+                                     delivered_,
+                                     rate_sample,
+                                     msg.ECE } );
+    }
+  }
+
+  if ( ecn() && msg.ECE && ackno_ > ecn_recover_ && !in_recovery_ ) {
+    // At most one reduction per window of data (RFC 3168 section 6.1.2)
+    ecn_recover_ = next_seqno_;
+    cwr_pending_ = true;
+    if ( congestion_control_ ) {
+      congestion_control_->on_ecn( next_seqno_ - ackno_, time_ms_ );
+    }
+  }
+
+  if ( rack_tlp() ) {
+    if ( tlp_end_.has_value() && ackno_ >= tlp_end_.value() ) {
+      // Without DSACK there's no telling whether the probe repaired a loss, so assume it did
+      // and respond as fast recovery would (RFC 8985 section 7.4.2)
+      tlp_end_.reset();
+      if ( congestion_control_ && !in_recovery_ && tlp_retransmitted_ ) { // new data repaired nothing
+        congestion_control_->on_loss( next_seqno_ - ackno_, time_ms_ );
+      }
+    }
+    rack_detect_loss();
+    arm_tail_loss_probe();
+  }
+
+  if ( frto_recover_.has_value() ) {
+    detect_spurious_rto( msg, acked > 0, duplicate );
+  }
+
+  const bool popped = outstanding_messages_.size() < outstanding_before;
+  timer_.restore_RTO();
+  if ( !outstanding_messages_.empty() && popped ) { // ack new data, sending data
+    timer_.start();                                 // that is, restart
+    consecutive_retransmissions_ = 0;
+  } else if ( outstanding_messages_.empty() ) { // all data sent
+    timer_.reset();
+    consecutive_retransmissions_ = 0;
+  } // do nothing when no data is newly acked
+  rearm_wakeup();
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::enter_recovery()
+{
+  in_recovery_ = true;
+  recover_ = next_seqno_;
+  for ( auto& seg : outstanding_messages_ ) {
+    seg.retransmitted = false;
+  }
+  retransmitted_bytes_ = 0;
+  high_rxt_ = ackno_;
+  if ( congestion_control_ ) {
+    congestion_control_->on_loss( next_seqno_ - ackno_, time_ms_ );
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::rack_update( const OutstandingSegment& seg )
+{
+  const uint64_t rtt = time_ms_ - seg.sent_ms;
+  if ( seg.transmissions > 1 && min_rtt_ms_.has_value() && rtt < min_rtt_ms_.value() ) {
+    return; // too quick to be for the retransmission: the original was delivered after all
+  }
+  const uint64_t end = seg.seqno + seg.message.sequence_length();
+  if ( !rack_xmit_ms_.has_value() || seg.sent_ms > rack_xmit_ms_.value()
+       || ( seg.sent_ms == rack_xmit_ms_.value() && end > rack_end_ ) ) {
+    rack_xmit_ms_ = seg.sent_ms;
+    rack_end_ = end;
+    rack_rtt_ms_ = rtt;
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::rack_detect_loss()
+{
+  rack_timer_ms_.reset();
+  if ( !rack_xmit_ms_.has_value() ) {
+    return;
+  }
+  const uint64_t reordering_window = min_rtt_ms_.value_or( 0 ) / 4;
+  std::vector<OutstandingSegment*> lost;
+  for ( auto& seg : outstanding_messages_ ) {
+    if ( seg.transmissions == 0 ) {
+      break; // new data goes out in order, so nothing above has been sent either
+    }
+    const uint64_t end = seg.seqno + seg.message.sequence_length();
+    const bool sent_before_delivered
+      = seg.sent_ms < rack_xmit_ms_.value() || ( seg.sent_ms == rack_xmit_ms_.value() && end < rack_end_ );
+    if ( seg.sacked || seg.queued || !sent_before_delivered ) {
+      continue;
+    }
+    const uint64_t deadline = seg.sent_ms + rack_rtt_ms_ + reordering_window;
+    if ( deadline > time_ms_ ) {
+      // Maybe just reordered: look again once the window closes
+      rack_timer_ms_ = std::min( rack_timer_ms_.value_or( deadline ), deadline );
+    } else {
+      lost.push_back( &seg );
+    }
+  }
+  if ( lost.empty() ) {
+    return;
+  }
+  if ( !in_recovery_ ) {
+    enter_recovery();
+  }
+  auto insert_at = ready_seqnos_.begin();
+  for ( OutstandingSegment* seg : lost ) {
+    mark_retransmitted( *seg );
+    seg->queued = true;
+    insert_at = ready_seqnos_.insert( insert_at, seg->seqno ) + 1;
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::arm_tail_loss_probe()
+{
+  if ( !rack_tlp() || in_recovery_ || tlp_end_.has_value() || outstanding_messages_.empty() ) {
+    tlp_timer_ms_.reset();
+    return;
+  }
+  // PTO = 2 SRTT, plus room for a delayed ACK if only one segment is out, and never past the RTO
+  uint64_t pto = TLP_DEFAULT_PTO_MS;
+  if ( rtt_estimator_.srtt_ms().has_value() ) {
+    pto = 2 * rtt_estimator_.srtt_ms().value();
+    pto += outstanding_messages_.size() == 1 ? TLP_MAX_ACK_DELAY_MS : 0;
+  }
+  tlp_timer_ms_ = time_ms_ + std::min( pto, timer_.remaining_ms() );
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::send_tail_loss_probe()
+{
+  tlp_timer_ms_.reset();
+  OutstandingSegment& last = outstanding_messages_.back();
+  if ( last.sacked ) {
+    return;
+  }
+  // New data makes the better probe (RFC 8985 section 7.3), so the first segment pushed but not
+  // yet sent goes now, pacing or not: its room in the window was taken when it was pushed. With
+  // none, the probe resends the last segment, as tick() can't read more from the stream.
+  const auto unsent = outstanding_at_or_after( sent_seqno_ );
+  tlp_retransmitted_ = unsent == outstanding_messages_.end();
+  queue_first( tlp_retransmitted_ ? last : *unsent );
+  tlp_unpaced_ = true;
+  tlp_end_ = next_seqno_;
+  timer_.start();
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::detect_spurious_rto( const TCPReceiverMessage& msg, bool new_data, bool duplicate )
+{
+  if ( duplicate ) {
+    frto_recover_.reset(); // the receiver is missing something: the timeout was real
+    return;
+  }
+  if ( !new_data ) {
+    return; // a window update says nothing either way
+  }
+  bool spurious = false;
+  if ( msg.TSecr.has_value() ) {
+    // Eifel: the ACK echoes the original transmission, which went out before the timeout
+    spurious = static_cast<int32_t>( msg.TSecr.value() - static_cast<uint32_t>( rto_sent_ms_ ) ) < 0;
+  } else {
+    // F-RTO: an ACK of everything at once means the retransmission filled the only hole, but a
+    // second ACK of new data means the segments sent before the timeout are arriving after all
+    if ( ++frto_acks_ == 1 && ackno_ < frto_recover_.value() ) {
+      return;
+    }
+    spurious = frto_acks_ >= 2;
+  }
+  frto_recover_.reset();
+  if ( !spurious ) {
+    return;
+  }
+  spurious_rtos_++;
+  consecutive_retransmissions_ = 0;
+  timer_.restore_RTO();
+  if ( congestion_control_ ) {
+    congestion_control_->on_spurious_rto( time_ms_ );
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::trim_partially_acked()
+{
+  if ( outstanding_messages_.empty() || ackno_ <= outstanding_messages_.front().seqno ) {
+    return;
+  }
+  // The receiver took only part of the oldest segment (say, because its window shrank): stop
+  // counting the acknowledged part as in flight, and resend only the rest
+  OutstandingSegment& seg = outstanding_messages_.front();
+  const uint64_t acked = ackno_ - seg.seqno;
+  seg.message.remove_prefix( acked );
+  sequence_numbers_in_flight_ -= acked;
+  if ( seg.sacked ) {
+    sacked_bytes_ -= acked;
+  } else {
+    lost_bytes_ -= seg.seqno < lost_end_ ? acked : 0;
+    retransmitted_bytes_ -= seg.retransmitted ? acked : 0;
+  }
+  seg.seqno = ackno_;
+  if ( seg.queued ) {
+    ready_seqnos_.push_front( seg.seqno ); // the entry under the old seqno now finds nothing
+  }
+  if ( seg.mtu_probe ) {
+    // Inconclusive: the path may not have carried the probe whole
+    seg.mtu_probe = false;
+    mtu_probe_in_flight_ = false;
+  }
+}
+
+template<typename Policy>
+std::optional<DeliveryRateSample> BasicTCPSender<Policy>::pop_acked_segments( std::optional<uint64_t>& rtt_ms )
+{
+  // The sample comes from the most recently sent of the segments this ACK fully acknowledged
+  std::optional<OutstandingSegment> newest {};
+  while ( !outstanding_messages_.empty()
+          && ackno_ >= outstanding_messages_.front().seqno + outstanding_messages_.front().message.sequence_length() ) {
+    OutstandingSegment& seg = outstanding_messages_.front();
+    sequence_numbers_in_flight_ -= seg.message.sequence_length();
+    // The highest segment acknowledged gives the RTT sample, unless it was retransmitted (Karn)
+    rtt_ms = seg.transmissions == 1 ? time_ms_ - seg.sent_ms : std::optional<uint64_t> {};
+    if ( rack_tlp() && !seg.sacked ) {
+      rack_update( seg );
+    }
+    if ( seg.mtu_probe ) {
+      // The probe got through: the path carries segments of this size
+      set_mss( seg.message.payload.size() );
+      mtu_probe_in_flight_ = false;
+      next_mtu_probe_ms_ = time_ms_ + MTU_REPROBE_INTERVAL_MS;
+    }
+    forget( seg );
+    if ( seg.transmissions > 0 && ( !newest.has_value() || seg.sent_ms >= newest->sent_ms ) ) {
+      newest = std::move( seg );
+    }
+    outstanding_messages_.pop_front();
+  }
+  trim_partially_acked();
+  if ( !newest.has_value() ) {
+    return {};
+  }
+
+  // The interval is the longer of the send and ACK phases, so neither sender bursts nor ACK
+  // compression can inflate the rate beyond what the path delivered
+  first_sent_ms_ = newest->sent_ms;
+  const uint64_t send_elapsed = newest->sent_ms - newest->first_sent_ms;
+  const uint64_t ack_elapsed = delivered_ms_ - newest->delivered_ms;
+  const uint64_t interval_ms = std::max( send_elapsed, ack_elapsed );
+  if ( interval_ms == 0 ) {
+    return {};
+  }
+  return DeliveryRateSample { ( delivered_ - newest->delivered ) * 1000 / interval_ms,
+                              time_ms_ - newest->sent_ms,
+                              newest->delivered,
+                              newest->app_limited };
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::tick( const size_t ms_since_last_tick )
+{
+  time_ms_ += ms_since_last_tick;
+  if ( timer_.started() ) {
+    timer_.add( ms_since_last_tick );
+    if ( timer_.expired() && mtu_probe_lost() ) {
+      // Only the probe's size was at fault: resend its data without backing off
+      timer_.reset();
+    } else if ( timer_.expired() ) {
+      retransmit_first_outstanding();
+      // Duplicate ACKs for data sent before the timeout must not start another recovery
+      recover_ = next_seqno_;
+      in_recovery_ = false;
+      duplicate_acks_ = 0;
+      tlp_timer_ms_.reset();
+      tlp_end_.reset();
+      // Only the first of a series of timeouts can be judged spurious
+      frto_recover_.reset();
+      if ( frto() && nonzero_window_size_ && consecutive_retransmissions_ == 0 ) {
+        frto_recover_ = next_seqno_;
+        frto_acks_ = 0;
+        rto_sent_ms_ = time_ms_;
+      }
+      if ( nonzero_window_size_ ) {
+        consecutive_retransmissions_++;
+        timer_.double_RTO();
+        if ( congestion_control_ ) {
+          congestion_control_->on_rto( next_seqno_ - ackno_, time_ms_ );
+        }
+      }
+      timer_.reset();
+    }
+  }
+  if ( rack_timer_ms_.has_value() && rack_timer_ms_.value() <= time_ms_ ) {
+    rack_detect_loss();
+  }
+  if ( tlp_timer_ms_.has_value() && tlp_timer_ms_.value() <= time_ms_ && !outstanding_messages_.empty() ) {
+    send_tail_loss_probe();
+  }
+  rearm_wakeup();
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::attach( TimingWheel& wheel, uint64_t tag )
+{
+  if ( wheel_.has_value() && wakeup_.has_value() ) {
+    wheel_->get().cancel( wakeup_.value() );
+  }
+  wheel_ = wheel;
+  wheel_tag_ = tag;
+  wheel_epoch_ms_ = wheel.now_ms() - time_ms_;
+  wakeup_.reset();
+  wakeup_ms_.reset();
+  rearm_wakeup();
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::wake()
+{
+  wakeup_.reset(); // It expired, which is why we're here
+  wakeup_ms_.reset();
+  catch_up();
+  rearm_wakeup();
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::catch_up()
+{
+  if ( wheel_.has_value() && wheel_->get().now_ms() - wheel_epoch_ms_ > time_ms_ ) {
+    tick( wheel_->get().now_ms() - wheel_epoch_ms_ - time_ms_ );
+  }
+}
+
+template<typename Policy>
+void BasicTCPSender<Policy>::rearm_wakeup()
+{
+  if ( !wheel_.has_value() ) {
+    return;
+  }
+  // Deadlines already passed were handled, or are stale (a probe with nothing left to probe)
+  std::optional<uint64_t> deadline;
+  const auto consider = [&]( std::optional<uint64_t> ms ) {
+    if ( ms.has_value() && ms.value() > time_ms_ ) {
+      deadline = std::min( deadline.value_or( ms.value() ), ms.value() );
+    }
+  };
+  consider( timer_.started() ? time_ms_ + timer_.remaining_ms() : std::optional<uint64_t> {} );
+  consider( rack_timer_ms_ );
+  consider( tlp_timer_ms_ );
+  consider( ready_seqnos_.empty() ? std::optional<uint64_t> {} : next_send_time() );
+  if ( deadline == wakeup_ms_ ) {
+    return;
+  }
+  if ( wakeup_.has_value() ) {
+    wheel_->get().cancel( wakeup_.value() );
+    wakeup_.reset();
+  }
+  wakeup_ms_ = deadline;
+  if ( deadline.has_value() ) {
+    wakeup_ = wheel_->get().schedule( deadline.value() - time_ms_, wheel_tag_ );
+  }
+}
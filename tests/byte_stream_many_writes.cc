@@ -5,9 +5,32 @@
 #include <algorithm>
 #include <exception>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 using namespace std;
 
+namespace {
+
+// Take the next bytes as a Buffer and pop them, keeping the slice the way a sender keeps a segment
+struct PopSlice : public Action<ByteStream>
+{
+  vector<Buffer>& slices_;
+  uint64_t len_;
+
+  PopSlice( vector<Buffer>& slices, uint64_t len ) : slices_( slices ), len_( len ) {}
+  string description() const override { return "peek_buffer(" + to_string( len_ ) + ") and pop it"; }
+  void execute( ByteStream& bs ) const override
+  {
+    slices_.push_back( bs.reader().peek_buffer( len_ ) );
+    bs.reader().pop( len_ );
+  }
+};
+
+} // namespace
+
 int main()
 {
   try {
@@ -39,6 +62,45 @@ int main()
       }
     }
 
+    {
+      ByteStreamTestHarness test { "one-byte writes sliced as they arrive share storage", CAPACITY };
+
+      vector<Buffer> slices;
+      for ( size_t i = 0; i < NREPS; ++i ) {
+        test.execute( Push { string( 1, static_cast<char>( 'a' + i % 26 ) ) } );
+        test.execute( PopSlice { slices, 1 } );
+        test.execute( BytesBuffered { 0 } );
+      }
+
+      // Every slice still holds its byte, and the bytes sit side by side in a single chunk rather
+      // than one chunk each
+      size_t chunks = 1;
+      for ( size_t i = 0; i < NREPS; ++i ) {
+        const string_view byte = slices.at( i );
+        if ( byte != string( 1, static_cast<char>( 'a' + i % 26 ) ) ) {
+          throw runtime_error( "slice " + to_string( i ) + " changed" );
+        }
+        chunks += i > 0 && byte.data() != string_view { slices.at( i - 1 ) }.data() + 1;
+      }
+      if ( chunks != 1 ) {
+        throw runtime_error( to_string( NREPS ) + " one-byte writes took " + to_string( chunks ) + " chunks" );
+      }
+    }
+
+    // Copies of a stream share its last chunk, but writes to one don't show up in the other
+    {
+      ByteStream original { CAPACITY };
+      original.writer().push( "ab" );
+      ByteStream copy = original;
+      original.writer().push( "cd" );
+      copy.writer().push( "xy" );
+      original.writer().push( "ef" );
+      if ( static_cast<string_view>( original.reader().peek_buffer( 6 ) ) != "abcdef"
+           || static_cast<string_view>( copy.reader().peek_buffer( 4 ) ) != "abxy" ) {
+        throw runtime_error( "writes to a copy of a stream leaked into the other" );
+      }
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
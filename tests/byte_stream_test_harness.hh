@@ -107,6 +107,28 @@ struct PeekOnce : public Peek
   }
 };
 
+struct PeekBuffer : public Expectation<ByteStream>
+{
+  uint64_t len_;
+  std::string output_;
+
+  PeekBuffer( uint64_t len, std::string output ) : len_( len ), output_( move( output ) ) {}
+
+  std::string description() const override
+  {
+    return "peek_buffer(" + std::to_string( len_ ) + ") gives \"" + Printer::prettify( output_ ) + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    const Buffer peeked = bs.reader().peek_buffer( len_ );
+    if ( static_cast<std::string_view>( peeked ) != output_ ) {
+      throw ExpectationViolation { "Expected \"" + Printer::prettify( output_ ) + "\" from peek_buffer(), but found \""
+                                   + Printer::prettify( peeked ) + "\"" };
+    }
+  }
+};
+
 struct IsClosed : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
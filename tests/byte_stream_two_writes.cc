@@ -125,6 +125,22 @@ int main()
       test.execute( BytesBuffered { 0 } );
     }
 
+    {
+      ByteStreamTestHarness test { "peek_buffer across writes", 15 };
+
+      test.execute( Push { "cat" } );
+      test.execute( Push { "tac" } );
+      test.execute( PeekBuffer { 2, "ca" } );
+      test.execute( PeekBuffer { 5, "catta" } );
+      test.execute( Pop { 2 } );
+      test.execute( PeekBuffer { 100, "ttac" } );
+      test.execute( PeekBuffer { 0, "" } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekBuffer { 1, "" } );
+      test.execute( Push { "dogs" } );
+      test.execute( PeekBuffer { 4, "dogs" } );
+    }
+
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,63 @@
+#include "random.hh"
+#include "test_should_be.hh"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    // xoshiro256** from the SplitMix64 expansion of seed 0
+    {
+      FastRandom rng { 0 };
+      test_should_be( rng(), uint64_t { 0x99ec5f36cb75f2b4 } );
+      test_should_be( rng(), uint64_t { 0xbf6e1f784956452a } );
+      test_should_be( rng(), uint64_t { 0x1a5f849d4933e6e0 } );
+    }
+
+    // Works with the standard distributions
+    {
+      FastRandom rng { process_seed() };
+      uniform_int_distribution<int> die { 1, 6 };
+      array<int, 7> counts {};
+      for ( int i = 0; i < 60000; i++ ) {
+        counts.at( die( rng ) )++;
+      }
+      for ( int face = 1; face <= 6; face++ ) {
+        test_should_be( counts.at( face ) > 9000 && counts.at( face ) < 11000, true );
+      }
+    }
+
+    // The per-thread generator and the seed are stable, and the seed is drawn only once
+    {
+      test_should_be( process_seed(), process_seed() );
+      test_should_be( &thread_random(), &thread_random() );
+      test_should_be( thread_random()() != thread_random()(), true );
+    }
+
+    // Successive ISNs of one connection advance with the 4 us clock; other connections' are unrelated
+    {
+      const uint32_t first = generate_isn( 0x0a000001, 1234, 0x0a000002, 80 );
+      const uint32_t second = generate_isn( 0x0a000001, 1234, 0x0a000002, 80 );
+      test_should_be( second - first < 250000, true ); // under a second apart
+      bool unrelated = false;
+      for ( uint16_t port = 1235; port < 1240; port++ ) {
+        unrelated |= generate_isn( 0x0a000001, port, 0x0a000002, 80 ) - second > 250000;
+      }
+      test_should_be( unrelated, true );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
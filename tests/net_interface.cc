@@ -320,6 +320,44 @@ int main()
         serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
       test.execute( ExpectNoFrame {} );
     }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "ECN marking past the queue threshold", local_eth, Address( "10.0.0.1", 0 ) };
+      test.execute( SetECNMarkingThreshold { 1 } );
+
+      test.execute( ReceiveFrame {
+        make_frame( remote_eth,
+                    ETHERNET_BROADCAST,
+                    EthernetHeader::TYPE_ARP,
+                    serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.5", {}, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+
+      auto ect = make_datagram( "5.6.7.8", "13.12.11.10" );
+      ect.header.set_ecn( IPv4Header::ECN_ECT0 );
+      ect.header.compute_checksum();
+      auto marked = ect;
+      marked.header.set_ecn( IPv4Header::ECN_CE );
+      marked.header.compute_checksum();
+      const auto not_ect = make_datagram( "5.6.7.8", "13.12.11.10" );
+
+      // the first datagram finds the queue empty; the ones behind it find it at the threshold
+      test.execute( SendDatagram { ect, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { ect, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { not_ect, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( ect ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( marked ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( not_ect ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
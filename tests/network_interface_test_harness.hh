@@ -135,6 +135,16 @@ struct Tick : public Action<NetworkInterface>
   explicit Tick( const size_t ms ) : _ms( ms ) {}
 };
 
+struct SetECNMarkingThreshold : public Action<NetworkInterface>
+{
+  size_t _frames;
+
+  std::string description() const override { return "mark CE at " + to_string( _frames ) + " queued frames"; }
+  void execute( NetworkInterface& interface ) const override { interface.set_ecn_marking_threshold( _frames ); }
+
+  explicit SetECNMarkingThreshold( const size_t frames ) : _frames( frames ) {}
+};
+
 inline std::string concat( std::vector<Buffer>& buffers )
 {
   return std::accumulate(
@@ -8,6 +8,7 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 using ReceiverSet = std::pair<StreamAndReassembler, TCPReceiver>;
 
@@ -34,6 +35,12 @@ public:
                    { { ByteStream { capacity }, Reassembler {} }, TCPReceiver {} } )
   {}
 
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity, const TCPConfig& config )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ),
+                   { { ByteStream { capacity }, Reassembler {} }, TCPReceiver { config } } )
+  {}
+
   template<std::derived_from<TestStep<StreamAndReassembler>> T>
   void execute( const T& test )
   {
@@ -94,6 +101,54 @@ struct ExpectAcknoBetween : public Expectation<ReceiverSet>
   }
 };
 
+struct ExpectTimestampEcho : public ExpectNumber<ReceiverSet, std::optional<uint32_t>>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "TSecr"; }
+  std::optional<uint32_t> value( ReceiverSet& rs ) const override
+  {
+    return rs.second.send( rs.first.first.writer() ).TSecr;
+  }
+};
+
+struct ExpectSACKBlocks : public Expectation<ReceiverSet>
+{
+  std::vector<std::pair<Wrap32, Wrap32>> blocks_;
+  explicit ExpectSACKBlocks( std::vector<std::pair<Wrap32, Wrap32>> blocks ) : blocks_( std::move( blocks ) ) {}
+
+  static std::string to_string( const std::vector<std::pair<Wrap32, Wrap32>>& blocks )
+  {
+    std::ostringstream desc;
+    desc << "{";
+    for ( const auto& [begin, end] : blocks ) {
+      desc << " [" << ::to_string( begin ) << ", " << ::to_string( end ) << ")";
+    }
+    desc << " }";
+    return desc.str();
+  }
+
+  std::string description() const override { return "SACK blocks = " + to_string( blocks_ ); }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    std::vector<std::pair<Wrap32, Wrap32>> blocks;
+    for ( const auto& block : rs.second.send( rs.first.first.writer() ).SACK ) {
+      blocks.emplace_back( block.begin, block.end );
+    }
+    if ( blocks != blocks_ ) {
+      throw ExpectationViolation { "TCPReceiver advertised SACK blocks " + to_string( blocks ) + ", expected "
+                                   + to_string( blocks_ ) };
+    }
+  }
+};
+
+struct ExpectECE : public ExpectBool<ReceiverSet>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "ECE"; }
+  bool value( ReceiverSet& rs ) const override { return rs.second.send( rs.first.first.writer() ).ECE; }
+};
+
 struct HasAckno : public ExpectBool<ReceiverSet>
 {
   using ExpectBool::ExpectBool;
@@ -135,6 +190,30 @@ struct SegmentArrives : public Action<ReceiverSet>
     return *this;
   }
 
+  SegmentArrives& with_payload( Buffer payload )
+  {
+    msg_.payload = std::move( payload );
+    return *this;
+  }
+
+  SegmentArrives& with_timestamp( uint32_t tsval )
+  {
+    msg_.TSval = tsval;
+    return *this;
+  }
+
+  SegmentArrives& with_cwr()
+  {
+    msg_.CWR = true;
+    return *this;
+  }
+
+  SegmentArrives& with_ecn( uint8_t ecn )
+  {
+    msg_.ECN = ecn;
+    return *this;
+  }
+
   SegmentArrives& without_ackno()
   {
     ackno_expected_ = HasAckno { false };
@@ -161,6 +240,15 @@ struct SegmentArrives : public Action<ReceiverSet>
     if ( msg_.FIN ) {
       ss << " +FIN";
     }
+    if ( msg_.TSval.has_value() ) {
+      ss << " TSval=" << msg_.TSval.value();
+    }
+    if ( msg_.CWR ) {
+      ss << " +CWR";
+    }
+    if ( msg_.ECN ) {
+      ss << " ecn=" << static_cast<int>( msg_.ECN );
+    }
     ss << ")";
 
     if ( ackno_expected_.value_ ) {
@@ -171,3 +259,41 @@ struct SegmentArrives : public Action<ReceiverSet>
     return ss.str();
   }
 };
+
+struct SegmentsCoalesced : public ExpectNumber<ReceiverSet, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "segments_coalesced"; }
+  uint64_t value( ReceiverSet& rs ) const override { return rs.second.segments_coalesced(); }
+};
+
+struct BatchArrives : public Action<ReceiverSet>
+{
+  std::vector<SegmentArrives> segs_ {};
+
+  BatchArrives& with_segment( SegmentArrives seg )
+  {
+    segs_.push_back( std::move( seg ) );
+    return *this;
+  }
+
+  void execute( ReceiverSet& rs ) const override
+  {
+    std::vector<TCPSenderMessage> msgs;
+    for ( const auto& seg : segs_ ) {
+      msgs.push_back( seg.msg_ );
+    }
+    rs.second.receive_batch( msgs, rs.first.second, rs.first.first.writer() );
+  }
+
+  std::string description() const override
+  {
+    std::ostringstream ss;
+    ss << "receive batch of " << segs_.size() << " segments: [";
+    for ( const auto& seg : segs_ ) {
+      ss << " " << seg.description();
+    }
+    ss << " ]";
+    return ss.str();
+  }
+};
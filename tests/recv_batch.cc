@@ -0,0 +1,127 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    /* back-to-back segments are merged */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "in-order burst coalesced", 4000 };
+      test.execute( BatchArrives {}
+                      .with_segment( SegmentArrives {}.with_syn().with_seqno( isn ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_fin() ) );
+      test.execute( SegmentsCoalesced { 3 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 14 } } );
+      test.execute( ReadAll { "abcdefghijkl" } );
+      test.execute( IsFinished { true } );
+    }
+
+    /* payloads sliced from one buffer, as the sender slices them from its stream, go in together */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "burst of slices from one buffer", 4000 };
+      const Buffer stream { "abcdefghijklmnopqrstuvwx" };
+      const auto slice = [&]( size_t pos ) { return stream.slice( pos, 4 ); };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      // The third slice doesn't carry on from the second in memory, and the fifth isn't in order
+      test.execute( BatchArrives {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_payload( slice( 0 ) ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_payload( slice( 4 ) ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 13 ).with_payload( slice( 12 ) ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 21 ).with_payload( slice( 20 ) ) ) );
+      test.execute( SegmentsCoalesced { 3 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 17 } } );
+      test.execute( BytesPending { 4 } );
+      test.execute( ReadAll { "abcdefghijklmnop" } );
+      test.execute(
+        BatchArrives {}.with_segment( SegmentArrives {}.with_seqno( isn + 17 ).with_payload( slice( 16 ) ) ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 25 } } );
+      test.execute( ReadAll { "qrstuvwx" } );
+    }
+
+    /* a hole splits the burst into runs */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "burst with a hole", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( BatchArrives {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mnop" ) ) );
+      test.execute( SegmentsCoalesced { 1 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( BytesPending { 8 } );
+      test.execute( BatchArrives {}.with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) ) );
+      test.execute( SegmentsCoalesced { 0 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 17 } } );
+      test.execute( ReadAll { "abcdefghijklmnop" } );
+    }
+
+    /* out-of-order and duplicate segments in a burst */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "reordered burst", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( BatchArrives {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) ) );
+      test.execute( SegmentsCoalesced { 1 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ReadAll { "abcdefgh" } );
+    }
+
+    /* a segment with an older timestamp is not merged past PAWS */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS inside a burst", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 100 ) );
+      test.execute(
+        BatchArrives {}
+          .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 110 ) )
+          .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "old!" ).with_timestamp( 90 ) )
+          .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 120 ) )
+          .with_segment( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_timestamp( 130 ) ) );
+      test.execute( SegmentsCoalesced { 1 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 13 } } );
+      test.execute( ExpectTimestampEcho { 120 } );
+      test.execute( ReadAll { "abcdefghijkl" } );
+    }
+
+    /* a rejected segment at the head of a burst takes nothing after it down with it */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "PAWS rejects the head of a burst", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_timestamp( 100 ) );
+      test.execute(
+        BatchArrives {}
+          .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_timestamp( 90 ) )
+          .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_timestamp( 120 ) ) );
+      test.execute( SegmentsCoalesced { 0 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( BytesPending { 4 } );
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( ExpectTimestampEcho { 100 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    /* CE is echoed on every ACK until the sender answers with CWR */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "ECE held until CWR", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_ecn( IPv4Header::ECN_ECT0 ) );
+      test.execute( ExpectECE { false } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_ecn( IPv4Header::ECN_CE ) );
+      test.execute( ExpectECE { true } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_ecn( IPv4Header::ECN_ECT0 ) );
+      test.execute( ExpectECE { true } );
+      test.execute(
+        SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mnop" ).with_ecn( IPv4Header::ECN_ECT0 ).with_cwr() );
+      test.execute( ExpectECE { false } );
+      test.execute( ExpectAckno { Wrap32 { isn + 17 } } );
+      test.execute( ReadAll { "abcdefghijklmnop" } );
+    }
+
+    /* a CE mark on the CWR segment itself starts a new echo */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "CE on CWR segment", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_ecn( IPv4Header::ECN_CE ) );
+      test.execute( ExpectECE { true } );
+      test.execute(
+        SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_ecn( IPv4Header::ECN_CE ).with_cwr() );
+      test.execute( ExpectECE { true } );
+    }
+
+    /* DCTCP echoes each segment's mark as it comes */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPConfig cfg;
+      cfg.congestion_control = CongestionControlAlgorithm::DCTCP;
+      TCPReceiverTestHarness test { "DCTCP precise ECE", 4000, cfg };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ).with_ecn( IPv4Header::ECN_CE ) );
+      test.execute( ExpectECE { true } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ).with_ecn( IPv4Header::ECN_ECT0 ) );
+      test.execute( ExpectECE { false } );
+      test.execute( ReadAll { "abcdefgh" } );
+    }
+
+    /* a batch is not coalesced across a change of ECN codepoint */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "batch split at CE", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( BatchArrives {}
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) )
+                      .with_segment( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) )
+                      .with_segment(
+                        SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ).with_ecn( IPv4Header::ECN_CE ) ) );
+      test.execute( ExpectECE { true } );
+      test.execute( SegmentsCoalesced { 1 } );
+      test.execute( ReadAll { "abcdefghijkl" } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
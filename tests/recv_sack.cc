@@ -0,0 +1,58 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    /* out-of-order data is advertised, most recent block first */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks advertised", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSACKBlocks { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 13 ).with_data( "mnop" ) );
+      test.execute( ExpectSACKBlocks {
+        { { Wrap32 { isn + 13 }, Wrap32 { isn + 17 } }, { Wrap32 { isn + 5 }, Wrap32 { isn + 9 } } } } );
+      // Filling in after a block extends it
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 5 }, Wrap32 { isn + 17 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 17 } } );
+      test.execute( ExpectSACKBlocks { {} } );
+      test.execute( ReadAll { "abcdefghijklmnop" } );
+    }
+
+    /* at most MAX_SACK_BLOCKS are advertised */
+    {
+      const uint32_t isn = uniform_int_distribution<uint32_t> { 0, UINT32_MAX }( rd );
+      TCPReceiverTestHarness test { "SACK blocks limited", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "g" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "i" ) );
+      test.execute( ExpectSACKBlocks { { { Wrap32 { isn + 9 }, Wrap32 { isn + 10 } },
+                                         { Wrap32 { isn + 3 }, Wrap32 { isn + 4 } },
+                                         { Wrap32 { isn + 5 }, Wrap32 { isn + 6 } } } } );
+      test.execute( BytesPending { 4 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -68,6 +68,27 @@ int main()
       test.execute( AckReceived { Wrap32 { isn + 2 } }.with_win( 1000 ) );
       test.execute( ExpectSeqnosInFlight { 1 } );
     }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+
+      TCPSenderTestHarness test { "Partial ACK trims the segment, and only the rest is resent", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abcdefgh" } );
+      test.execute( ExpectMessage {}.with_data( "abcdefgh" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectSeqnosInFlight { 8 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 5 } );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_data( "defgh" ).with_seqno( isn + 4 ) );
+      test.execute( AckReceived { Wrap32 { isn + 9 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
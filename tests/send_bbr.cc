@@ -0,0 +1,304 @@
+#include "bbr.hh"
+#include "random.hh"
+#include "reassembler.hh"
+#include "sender_test_harness.hh"
+#include "tcp_receiver.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const BBRCongestionControl& bbr( const StreamAndSender& ss )
+{
+  const auto* cc = dynamic_cast<const BBRCongestionControl*>( ss.second.congestion_control() );
+  if ( cc == nullptr ) {
+    throw ExpectationViolation { "TCPSender is not using BBR" };
+  }
+  return *cc;
+}
+
+// One round trip over a bottleneck: keep the stream full, send everything the sender allows,
+// let `rtt_ms` pass, then acknowledge at most `bottleneck` sequence numbers of it.
+struct BottleneckRound : public Action<StreamAndSender>
+{
+  Wrap32 isn_;
+  uint64_t rtt_ms_;
+  uint64_t bottleneck_;
+  BottleneckRound( Wrap32 isn, uint64_t rtt_ms, uint64_t bottleneck )
+    : isn_( isn ), rtt_ms_( rtt_ms ), bottleneck_( bottleneck )
+  {}
+
+  string description() const override
+  {
+    ostringstream desc;
+    desc << "send a flight, " << rtt_ms_ << " ms pass, ACK up to " << bottleneck_ << " of it";
+    return desc.str();
+  }
+
+  void execute( StreamAndSender& ss ) const override
+  {
+    ss.first.writer().push( string( ss.first.writer().available_capacity(), 'x' ) );
+    ss.second.push( ss.first.reader() );
+    while ( ss.second.maybe_send().has_value() ) {}
+    // Everything pushed has now been sent: sent_end is the SYN plus every byte popped
+    const uint64_t sent_end = 1 + ss.first.reader().bytes_popped();
+    const uint64_t ackno = sent_end - ss.second.sequence_numbers_in_flight();
+    ss.second.tick( rtt_ms_ );
+    ss.second.receive( { isn_ + static_cast<uint32_t>( min( ackno + bottleneck_, sent_end ) ), UINT16_MAX } );
+  }
+};
+
+// The far side of a bottleneck that loses every 100th segment sent into it: a real receiver behind
+// a queue it drains at a fixed rate
+struct LossyPath
+{
+  static constexpr uint64_t LOSS_INTERVAL = 100;
+
+  ByteStream inbound { TCPConfig::DEFAULT_CAPACITY * 2 };
+  Reassembler reassembler {};
+  TCPReceiver receiver {};
+  deque<TCPSenderMessage> queue {};
+  uint64_t segments_sent {};
+  vector<uint64_t> delivered {}; // Bytes of the stream delivered in each round
+};
+
+// One round trip over the lossy bottleneck: keep the stream full, send everything the sender
+// allows into the queue, let `rtt_ms` pass, then deliver up to `bottleneck` sequence numbers from
+// the queue, the receiver acknowledging each segment as it arrives.
+struct LossyBottleneckRound : public Action<StreamAndSender>
+{
+  LossyPath& path_;
+  uint64_t rtt_ms_;
+  uint64_t bottleneck_;
+  LossyBottleneckRound( LossyPath& path, uint64_t rtt_ms, uint64_t bottleneck )
+    : path_( path ), rtt_ms_( rtt_ms ), bottleneck_( bottleneck )
+  {}
+
+  string description() const override
+  {
+    ostringstream desc;
+    desc << "send a flight, losing 1 in " << LossyPath::LOSS_INTERVAL << ", " << rtt_ms_ << " ms pass, deliver up to "
+         << bottleneck_ << " of the queue";
+    return desc.str();
+  }
+
+  void execute( StreamAndSender& ss ) const override
+  {
+    ss.first.writer().push( string( ss.first.writer().available_capacity(), 'x' ) );
+    ss.second.push( ss.first.reader() );
+    while ( const auto message = ss.second.maybe_send() ) {
+      if ( ++path_.segments_sent % LossyPath::LOSS_INTERVAL != 0 ) {
+        path_.queue.push_back( message.value() );
+      }
+    }
+    ss.second.tick( rtt_ms_ );
+    const uint64_t before = path_.inbound.writer().bytes_pushed();
+    for ( uint64_t budget = bottleneck_; !path_.queue.empty() && path_.queue.front().sequence_length() <= budget; ) {
+      budget -= path_.queue.front().sequence_length();
+      path_.receiver.receive( path_.queue.front(), path_.reassembler, path_.inbound.writer() );
+      path_.queue.pop_front();
+      ss.second.receive( path_.receiver.send( path_.inbound.writer() ) );
+    }
+    path_.delivered.push_back( path_.inbound.writer().bytes_pushed() - before );
+    path_.inbound.reader().pop( path_.inbound.reader().bytes_buffered() );
+  }
+};
+
+// The stream's delivery rate over the path's last `rounds` rounds is within 10% of `rate`
+struct ExpectDeliveryRate : public Expectation<StreamAndSender>
+{
+  const LossyPath& path_;
+  uint64_t rounds_;
+  uint64_t rtt_ms_;
+  uint64_t rate_;
+  ExpectDeliveryRate( const LossyPath& path, uint64_t rounds, uint64_t rtt_ms, uint64_t rate )
+    : path_( path ), rounds_( rounds ), rtt_ms_( rtt_ms ), rate_( rate )
+  {}
+
+  string description() const override
+  {
+    return "delivery rate over the last " + to_string( rounds_ ) + " rounds near " + to_string( rate_ );
+  }
+
+  void execute( StreamAndSender& /* ss */ ) const override
+  {
+    const size_t first = path_.delivered.size() - min<size_t>( rounds_, path_.delivered.size() );
+    uint64_t bytes = 0;
+    for ( size_t i = first; i < path_.delivered.size(); i++ ) {
+      bytes += path_.delivered[i];
+    }
+    const uint64_t rate = bytes * 1000 / ( rounds_ * rtt_ms_ );
+    if ( rate * 10 < rate_ * 9 || rate * 10 > rate_ * 11 ) {
+      throw ExpectationViolation { "delivery rate was " + to_string( rate ) + ", expected about "
+                                   + to_string( rate_ ) };
+    }
+  }
+};
+
+struct ExpectBBRMode : public Expectation<StreamAndSender>
+{
+  BBRCongestionControl::Mode mode_;
+  explicit ExpectBBRMode( BBRCongestionControl::Mode mode ) : mode_( mode ) {}
+  static string name( BBRCongestionControl::Mode mode )
+  {
+    switch ( mode ) {
+      case BBRCongestionControl::Mode::STARTUP:
+        return "STARTUP";
+      case BBRCongestionControl::Mode::DRAIN:
+        return "DRAIN";
+      case BBRCongestionControl::Mode::PROBE_BW:
+        return "PROBE_BW";
+      case BBRCongestionControl::Mode::PROBE_RTT:
+        return "PROBE_RTT";
+    }
+    return "unknown";
+  }
+  string description() const override { return "BBR mode = " + name( mode_ ); }
+  void execute( StreamAndSender& ss ) const override
+  {
+    if ( bbr( ss ).mode() != mode_ ) {
+      throw ExpectationViolation { "BBR mode was " + name( bbr( ss ).mode() ) + ", expected " + name( mode_ ) };
+    }
+  }
+};
+
+struct ExpectBottleneckBandwidth : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  string name() const override { return "BBR btl_bw"; }
+  uint64_t value( StreamAndSender& ss ) const override { return bbr( ss ).btl_bw(); }
+};
+
+// Within 10% of the expected estimate
+struct ExpectBottleneckBandwidthNear : public Expectation<StreamAndSender>
+{
+  uint64_t btl_bw_;
+  explicit ExpectBottleneckBandwidthNear( uint64_t btl_bw ) : btl_bw_( btl_bw ) {}
+  string description() const override { return "BBR btl_bw near " + to_string( btl_bw_ ); }
+  void execute( StreamAndSender& ss ) const override
+  {
+    const uint64_t btl_bw = bbr( ss ).btl_bw();
+    if ( btl_bw * 10 < btl_bw_ * 9 || btl_bw * 10 > btl_bw_ * 11 ) {
+      throw ExpectationViolation { "BBR btl_bw was " + to_string( btl_bw ) + ", expected about "
+                                   + to_string( btl_bw_ ) };
+    }
+  }
+};
+
+struct ExpectMinRTT : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  string name() const override { return "BBR min_rtt_ms"; }
+  uint64_t value( StreamAndSender& ss ) const override { return bbr( ss ).min_rtt_ms().value_or( 0 ); }
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    const uint64_t iw = CongestionControl::INITIAL_WINDOW_SEGMENTS * mss;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::BBR;
+
+      TCPSenderTestHarness test { "BBR: first flight gives bandwidth and RTT estimates", cfg };
+      test.execute( ExpectCongestionWindow { iw } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 10 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( 10 * mss ) } }.with_win( 60000 ) );
+      // 10 segments delivered in 100 ms
+      test.execute( ExpectBottleneckBandwidth { 100 * mss } );
+      test.execute( ExpectMinRTT { 100 } );
+      test.execute( ExpectBBRMode { BBRCongestionControl::Mode::STARTUP } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::BBR;
+
+      TCPSenderTestHarness test { "BBR: leaves STARTUP once the bottleneck is full", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( UINT16_MAX ) );
+      // The bottleneck delivers 20 segments per 100 ms round trip
+      for ( size_t round = 0; round < 8; round++ ) {
+        test.execute( BottleneckRound { isn, 100, 20 * mss } );
+      }
+      test.execute( ExpectBottleneckBandwidth { 200 * mss } );
+      test.execute( ExpectMinRTT { 100 } );
+      test.execute( ExpectBBRMode { BBRCongestionControl::Mode::DRAIN } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::BBR;
+
+      TCPSenderTestHarness test { "BBR: 1% loss leaves the bandwidth estimate and delivery rate at the bottleneck",
+                                  cfg };
+      // The bottleneck delivers 20 segments per 100 ms round trip, and drops one segment in 100
+      LossyPath path;
+      for ( size_t round = 0; round < 20; round++ ) {
+        test.execute( LossyBottleneckRound { path, 100, 20 * mss } );
+      }
+      for ( size_t round = 0; round < 50; round++ ) {
+        test.execute( LossyBottleneckRound { path, 100, 20 * mss } );
+        test.execute( ExpectBottleneckBandwidthNear { 200 * mss } );
+      }
+      test.execute( ExpectDeliveryRate { path, 50, 100, 200 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.congestion_control = CongestionControlAlgorithm::BBR;
+
+      TCPSenderTestHarness test { "BBR: timeout collapses the window to one segment", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.coalescing = Coalescing::NAGLE;
+
+      TCPSenderTestHarness test { "Nagle: small writes wait for the outstanding one to be acknowledged", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4000 ) );
+      test.execute( Push { "ab" } );
+      test.execute( ExpectMessage {}.with_data( "ab" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "cd" } );
+      test.execute( Push { "ef" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectUnsentBytes { 4 } );
+      test.execute( AckReceived { Wrap32 { isn + 3 } }.with_win( 4000 ) );
+      test.execute( ExpectMessage {}.with_data( "cdef" ).with_seqno( isn + 3 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.coalescing = Coalescing::NAGLE;
+
+      TCPSenderTestHarness test { "Nagle: full segments go out, the short tail waits", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4000 ) );
+      test.execute( Push { "x" } );
+      test.execute( ExpectMessage {}.with_payload_size( 1 ) );
+      test.execute( Push { string( 2 * mss + 10, 'y' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 2 ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 2 + mss ) );
+      test.execute( ExpectNoSegment {} );
+      // Closing the stream releases the tail, with the FIN
+      test.execute( Close {} );
+      test.execute( ExpectMessage {}.with_payload_size( 10 ).with_fin( true ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.coalescing = Coalescing::CORK;
+
+      TCPSenderTestHarness test { "Cork: hold short segments until a full one or a flush", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4000 ) );
+      test.execute( Push { "abcd" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Push { string( mss, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_payload_size( 4 ).with_seqno( isn + 1 + mss ) );
+      // The flush covers only what was written before it
+      test.execute( Push { "efgh" } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_data( "efgh" ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "No delay: every write goes out at once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4000 ) );
+      test.execute( Push { "ab" } );
+      test.execute( Push { "cd" } );
+      test.execute( ExpectMessage {}.with_data( "ab" ) );
+      test.execute( ExpectMessage {}.with_data( "cd" ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.coalescing = Coalescing::CORK;
+
+      TCPSenderTestHarness test { "Cork: the SYN goes out even with a short write waiting", cfg };
+      test.execute( Receive { { nullopt, 1000 } }.without_push() );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectUnsentBytes { 3 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Flush {} );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+    const uint64_t iw = CongestionControl::INITIAL_WINDOW_SEGMENTS * mss;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Without congestion control, only the receive window limits sending", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { UINT64_MAX } );
+      test.execute( Push { string( 20 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 20; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+
+    for ( auto algorithm : { CongestionControlAlgorithm::RENO, CongestionControlAlgorithm::CUBIC } ) {
+      const string name = algorithm == CongestionControlAlgorithm::RENO ? "Reno" : "CUBIC";
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = algorithm;
+
+      TCPSenderTestHarness test { name + ": initial window limits the first flight", cfg };
+      test.execute( ExpectCongestionWindow { iw } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { iw + 1 } );
+      test.execute( Push { string( 20 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { iw + 1 } );
+
+      // Slow start: each ACK grows the window by at most one MSS
+      test.execute( AckReceived { Wrap32 { isn + 1 + 5 * mss } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { iw + 1 + mss } );
+      for ( size_t i = 0; i < 6; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { iw + 1 + mss } );
+    }
+
+    for ( auto algorithm : { CongestionControlAlgorithm::RENO, CongestionControlAlgorithm::CUBIC } ) {
+      const string name = algorithm == CongestionControlAlgorithm::RENO ? "Reno" : "CUBIC";
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t rto = uniform_int_distribution<uint16_t> { 30, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = rto;
+      cfg.congestion_control = algorithm;
+
+      TCPSenderTestHarness test { name + ": timeout collapses the window to one segment", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( Tick { rto } );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( Push { string( 4 * mss, 'y' ) } );
+      test.execute( ExpectNoSegment {} );
+
+      // Back in slow start after the timeout
+      test.execute( AckReceived { Wrap32 { isn + 1 + 4 * mss } }.with_win( 60000 ) );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( string( mss, 'y' ) ) );
+      test.execute( ExpectMessage {}.with_no_flags().with_data( string( mss, 'y' ) ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+      cfg.ecn = true;
+
+      TCPSenderTestHarness test { "Reno: ECE halves the window once per window of data", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_ecn( IPv4Header::ECN_NOT_ECT ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 8 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 8; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_ecn( IPv4Header::ECN_ECT0 ).with_cwr( false ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 1 + 2 * mss } }.with_win( 60000 ).with_ece() );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( ExpectNoSegment {} );
+      // Still echoed for data sent before the reduction: no second cut
+      test.execute( AckReceived { Wrap32 { isn + 1 + 4 * mss } }.with_win( 60000 ).with_ece() );
+      test.execute( ExpectCongestionWindow { 3 * mss } );
+      test.execute( AckReceived { Wrap32 { isn + 1 + 8 * mss } }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      // The next new data tells the receiver the window was reduced
+      test.execute( Push { "abcd" } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_ecn( IPv4Header::ECN_ECT0 ).with_cwr( true ) );
+      test.execute( Push { "efgh" } );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_ecn( IPv4Header::ECN_ECT0 ).with_cwr( false ) );
+      // Retransmissions are not ECN-capable
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_ecn( IPv4Header::ECN_NOT_ECT ).with_cwr( false ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "ECE is ignored without ECN", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 2 * mss, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_ecn( IPv4Header::ECN_NOT_ECT ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_ecn( IPv4Header::ECN_NOT_ECT ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 + mss } }.with_win( 60000 ).with_ece() );
+      test.execute( ExpectCongestionWindow { 11 * mss + 1 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::DCTCP;
+
+      TCPSenderTestHarness test { "DCTCP: the cut is scaled by the fraction of marked bytes", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 8 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 8; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ).with_ecn( IPv4Header::ECN_ECT0 ) );
+      }
+      // alpha = 15/16 after the unmarked SYN, then (15/16)^2 + 1/16 after this marked segment
+      test.execute( AckReceived { Wrap32 { isn + 1 + mss } }.with_win( 60000 ).with_ece() );
+      test.execute( ExpectCongestionWindow { 5822 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -477,8 +477,8 @@ int main()
       test.execute( AckReceived { Wrap32 { isn + 12 } }.with_win( 1000 ) );
       test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
       test.execute( Tick { 5 * rto } );
-      test.execute(
-        ExpectMessage {}.with_payload_size( 4 ).with_data( "ijkl" ).with_seqno( isn + 8 ).with_fin( true ) );
+      // "ijkl" was acknowledged, so only the FIN is resent
+      test.execute( ExpectMessage {}.with_payload_size( 0 ).with_seqno( isn + 12 ).with_fin( true ) );
       test.execute( ExpectNoSegment {} );
       test.execute( AckReceived( Wrap32 { isn + 13 } ).with_win( 1000 ) );
       test.execute( AckReceived( Wrap32 { isn + 1 } ).with_win( 1000 ) );
@@ -0,0 +1,127 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Third duplicate ACK retransmits the first outstanding segment", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abcd" } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "efgh" } );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( Push { "ijkl" } );
+      test.execute( ExpectMessage {}.with_data( "ijkl" ).with_seqno( isn + 9 ) );
+      test.execute( Push { "mnop" } );
+      test.execute( ExpectMessage {}.with_data( "mnop" ).with_seqno( isn + 13 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+      // Further duplicates during recovery don't retransmit again
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 17 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Window updates are not duplicate ACKs", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abcd" } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( Push { "efgh" } );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 999 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 998 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 997 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Partial ACK during recovery retransmits the next hole", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const string data : { "abcd", "efgh", "ijkl", "mnop", "qrst" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      // "abcd" and "ijkl" are lost
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 9 } }.with_win( 1000 ) );
+      test.execute( ExpectMessage {}.with_data( "ijkl" ).with_seqno( isn + 9 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 21 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "Reno: fast retransmit halves the window", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 10 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      for ( size_t i = 0; i < 3; i++ ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      }
+      test.execute( ExpectCongestionWindow { 5 * mss } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
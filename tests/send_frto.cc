@@ -0,0 +1,134 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+struct ExpectSpuriousRTOs : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  string name() const override { return "spurious_rtos"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.spurious_rtos(); }
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.frto = true;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "F-RTO: two ACKs of new data undo the timeout", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute( ExpectRTO { 2 * TCPConfig::TIMEOUT_DFLT } );
+      // The originals were only delayed: their ACKs arrive one after another
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( mss ) } }.with_win( 60000 ) );
+      test.execute( ExpectSpuriousRTOs { 0 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( 2 * mss ) } }.with_win( 60000 ) );
+      test.execute( ExpectSpuriousRTOs { 1 } );
+      test.execute( ExpectCongestionWindow { 10 * mss + 1 } );
+      test.execute( ExpectRTO { TCPConfig::TIMEOUT_DFLT } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.frto = true;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "F-RTO: an ACK of everything means the timeout was real", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( 4 * mss ) } }.with_win( 60000 ) );
+      test.execute( ExpectSpuriousRTOs { 0 } );
+      test.execute( ExpectCongestionWindow { 2 * mss } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.frto = true;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "F-RTO: a duplicate ACK means the timeout was real", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      }
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( mss ) } }.with_win( 60000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( mss ) } }.with_win( 60000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( 2 * mss ) } }.with_win( 60000 ) );
+      test.execute( ExpectSpuriousRTOs { 0 } );
+      test.execute( ExpectCongestionWindow { 2 * mss } ); // ssthresh: half the flight at the timeout
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.frto = true;
+      cfg.congestion_control = CongestionControlAlgorithm::CUBIC;
+
+      TCPSenderTestHarness test { "Eifel: an echo of the original transmission undoes the timeout", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 10 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 2 * mss, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      test.execute( ExpectMessage {}.with_payload_size( mss ) );
+      test.execute( Tick { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_payload_size( mss ).with_seqno( isn + 1 ) );
+      test.execute( ExpectCongestionWindow { mss } );
+      test.execute(
+        AckReceived { Wrap32 { isn + 1 + static_cast<uint32_t>( mss ) } }.with_win( 60000 ).with_tsecr( 10 ) );
+      test.execute( ExpectSpuriousRTOs { 1 } );
+      test.execute( ExpectCongestionWindow { 10 * mss + 1 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
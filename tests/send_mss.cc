@@ -0,0 +1,101 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 9000;
+
+      TCPSenderTestHarness test { "Configured MSS sets the segment size", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ) );
+      test.execute( Push { string( 20000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 9000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 9000 ).with_seqno( isn + 9001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 2000 ).with_seqno( isn + 18001 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 9000;
+
+      TCPSenderTestHarness test { "The peer's MSS option caps the segment size", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 5000 ).with_mss( 1460 ) );
+      test.execute( Push { string( 4000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1460 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1080 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.super_segments = true;
+
+      TCPSenderTestHarness test { "Super segments carry many MSS at once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 30500, 'x' ) }.with_close() );
+      test.execute( ExpectMessage {}.with_payload_size( 30500 ).with_fin( true ).with_seqno( isn + 1 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectSeqnosInFlight { 30501 } );
+    }
+
+    /* TCPSenderMessage::split() cuts a super segment into MSS-sized ones */
+    {
+      const Wrap32 isn( rd() );
+      string data( 2500, 'x' );
+      data[1000] = 'y';
+      const TCPSenderMessage super { isn, true, data, true, 42 };
+      const auto pieces = super.split( 1000 );
+      const auto check = [&]( bool ok, const string& what ) {
+        if ( !ok ) {
+          throw runtime_error( "split(): " + what );
+        }
+      };
+      check( pieces.size() == 3, "expected 3 pieces" );
+      check( pieces[0].seqno == isn && pieces[0].SYN && !pieces[0].FIN, "first piece" );
+      check( pieces[1].seqno == isn + 1001 && !pieces[1].SYN && !pieces[1].FIN, "middle piece" );
+      check( static_cast<string>( pieces[1].payload ).front() == 'y', "middle piece payload" );
+      check( pieces[2].seqno == isn + 2001 && pieces[2].payload.size() == 500 && pieces[2].FIN, "last piece" );
+      check( pieces[2].TSval == 42U, "TSval" );
+      size_t total = 0;
+      for ( const auto& piece : pieces ) {
+        total += piece.sequence_length();
+      }
+      check( total == super.sequence_length(), "sequence numbers are preserved" );
+      check( TCPSenderMessage { isn, false, string( 10, 'x' ), false, {} }.split( 1000 ).size() == 1,
+             "small segments are untouched" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+struct ExpectMSS : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  string name() const override { return "mss"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.second.mss(); }
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 1400;
+      cfg.mtu_probing = true;
+
+      TCPSenderTestHarness test { "An acknowledged probe raises the MSS", cfg };
+      test.execute( ExpectMSS { 1000 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ) );
+      test.execute( Push { string( 3000, 'x' ) } );
+      // Halfway between the 1000 bytes known to work and the configured 1400
+      test.execute( ExpectMessage {}.with_payload_size( 1200 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1201 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 800 ).with_seqno( isn + 2201 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 3001 } }.with_win( 20000 ) );
+      test.execute( ExpectMSS { 1200 } );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1300 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1200 ).with_seqno( isn + 4301 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 500 ).with_seqno( isn + 5501 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = 1000;
+      cfg.mss = 1400;
+      cfg.mtu_probing = true;
+
+      TCPSenderTestHarness test { "A probe lost to timeout is resent at the old MSS without backoff", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ) );
+      test.execute( Push { string( 2000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1200 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 800 ).with_seqno( isn + 1201 ) );
+      test.execute( Tick { 1000 } );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 200 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectRTO { 1000 } );
+      test.execute( AckReceived { Wrap32 { isn + 2001 } }.with_win( 20000 ) );
+      test.execute( ExpectMSS { 1000 } );
+      // The search continues below the size that failed
+      test.execute( Push { string( 2000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1100 ).with_seqno( isn + 2001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 900 ).with_seqno( isn + 3101 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      cfg.mss = 1400;
+      cfg.mtu_probing = true;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "Reno: a lost probe does not shrink the window", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ) );
+      // Slow start counted the SYN
+      test.execute( ExpectCongestionWindow { 10 * mss + 1 } );
+      test.execute( Push { string( 4200, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1200 ).with_seqno( isn + 1 ) );
+      for ( size_t i = 0; i < 3; i++ ) {
+        test.execute( ExpectMessage {}.with_payload_size( 1000 ) );
+      }
+      for ( size_t i = 0; i < 3; i++ ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ) );
+      }
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 200 ).with_seqno( isn + 1001 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectCongestionWindow { 10 * mss + 1 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 9000;
+      cfg.mtu_probing = true;
+
+      TCPSenderTestHarness test { "Probes never exceed the peer's MSS", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 20000 ).with_mss( 1100 ) );
+      test.execute( Push { string( 3000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1050 ).with_seqno( isn + 1 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 1000 ).with_seqno( isn + 1051 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 950 ).with_seqno( isn + 2051 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 3001 } }.with_win( 20000 ).with_mss( 1100 ) );
+      test.execute( ExpectMSS { 1050 } );
+      test.execute( Push { string( 2000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1075 ).with_seqno( isn + 3001 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 925 ).with_seqno( isn + 4076 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5001 } }.with_win( 20000 ).with_mss( 1100 ) );
+      test.execute( ExpectMSS { 1075 } );
+      // 1075 is within MTU_PROBE_PRECISION of 1100: the search is over
+      test.execute( Push { string( 2000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_payload_size( 1075 ) );
+      test.execute( ExpectMessage {}.with_payload_size( 925 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.notsent_lowat = 6;
+
+      TCPSenderTestHarness test { "Writable only while the unsent backlog is below the low-water mark", cfg };
+      test.execute( ExpectWritable { true } );
+      test.execute( Push {} );
+      test.execute( ExpectUnsentBytes { 1 } );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectUnsentBytes { 0 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4 ) );
+      // Four bytes are packetized but not yet sent; four more wait in the stream
+      test.execute( Push { "abcdefgh" } );
+      test.execute( ExpectUnsentBytes { 8 } );
+      test.execute( ExpectWritable { false } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectUnsentBytes { 4 } );
+      test.execute( ExpectWritable { true } );
+      // Retransmissions don't count: that data was sent once already
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_data( "abcd" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectUnsentBytes { 4 } );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 4 ) );
+      test.execute( ExpectMessage {}.with_data( "efgh" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectUnsentBytes { 0 } );
+      test.execute( ExpectWritable { true } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Always writable without a low-water mark", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 4 ) );
+      test.execute( Push { string( 1000, 'x' ) } );
+      test.execute( ExpectUnsentBytes { 1000 } );
+      test.execute( ExpectWritable { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
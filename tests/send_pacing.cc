@@ -0,0 +1,92 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+      cfg.pacing = true;
+
+      TCPSenderTestHarness test { "Unpaced until there is an RTT sample", cfg };
+      test.execute( ExpectNextSendTime { {} } );
+      test.execute( Push {} );
+      test.execute( ExpectNextSendTime { 0 } );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectNextSendTime { {} } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+      cfg.pacing = true;
+
+      TCPSenderTestHarness test { "Segments are released at the pacing rate", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      // cwnd = 10001 and SRTT = 100 ms: two windows per RTT is 200020 bytes/s, 4999 us per segment
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      test.execute( ExpectNextSendTime { 100 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectNextSendTime { 104 } );
+      test.execute( Tick { 3 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectNextSendTime { 109 } );
+      // Idle time doesn't build up credit for a burst
+      test.execute( Tick { 50 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectNextSendTime { 158 } );
+      test.execute( Tick { 4 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      test.execute( ExpectNextSendTime { {} } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+
+      TCPSenderTestHarness test { "Without pacing the whole window goes at once", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 100 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push { string( 4 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 4; i++ ) {
+        test.execute( ExpectMessage {}.with_no_flags().with_payload_size( mss ) );
+      }
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
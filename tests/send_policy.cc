@@ -0,0 +1,104 @@
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+using RenoSender = BasicTCPSender<RenoSenderPolicy>;
+
+// A profile of one's own: the shipped policies are compiled once, but any other one still links
+struct SmallSegmentPolicy : RenoSenderPolicy
+{
+  static constexpr optional<uint16_t> MSS { 500 };
+};
+
+using SmallSegmentSender = BasicTCPSender<SmallSegmentPolicy>;
+
+template<typename Sender>
+struct ExpectRenoController : public ExpectBool<BasicStreamAndSender<Sender>>
+{
+  using ExpectBool<BasicStreamAndSender<Sender>>::ExpectBool;
+  string name() const override { return "congestion controller is Reno"; }
+  bool value( BasicStreamAndSender<Sender>& ss ) const override
+  {
+    return dynamic_cast<const RenoCongestionControl*>( ss.second.congestion_control() ) != nullptr;
+  }
+};
+
+template<typename Sender>
+struct ExpectPaced : public ExpectBool<BasicStreamAndSender<Sender>>
+{
+  using ExpectBool<BasicStreamAndSender<Sender>>::ExpectBool;
+  string name() const override { return "paced"; }
+  bool value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.pacing_rate().has_value(); }
+};
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint64_t mss = TCPConfig::MAX_PAYLOAD_SIZE;
+      cfg.fixed_isn = isn;
+      // The policy fixes the controller and compiles out the rest, whatever the config asks for
+      cfg.congestion_control = CongestionControlAlgorithm::BBR;
+      cfg.ecn = true;
+      cfg.pacing = true;
+
+      TCPSenderTestHarness<RenoSender> test { "Reno policy overrides the config", cfg };
+      test.execute( ExpectRenoController<RenoSender> { true } );
+      test.execute( Push<RenoSender> {} );
+      test.execute( ExpectMessage<RenoSender> {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived<RenoSender> { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push<RenoSender> { string( 10 * mss, 'x' ) } );
+      for ( size_t i = 0; i < 10; i++ ) {
+        test.execute( ExpectMessage<RenoSender> {}.with_payload_size( mss ).with_ecn( IPv4Header::ECN_NOT_ECT ) );
+      }
+      test.execute( ExpectPaced<RenoSender> { false } );
+      for ( size_t i = 0; i < 3; i++ ) {
+        test.execute( AckReceived<RenoSender> { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      }
+      test.execute( ExpectCongestionWindow<RenoSender> { 5 * mss } );
+      test.execute( ExpectMessage<RenoSender> {}.with_seqno( isn + 1 ).with_payload_size( mss ) );
+      test.execute( ExpectNoSegment<RenoSender> {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness<SmallSegmentSender> test { "An out-of-tree policy instantiates the sender", cfg };
+      test.execute( ExpectRenoController<SmallSegmentSender> { true } );
+      test.execute( Push<SmallSegmentSender> {} );
+      test.execute( ExpectMessage<SmallSegmentSender> {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived<SmallSegmentSender> { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( Push<SmallSegmentSender> { string( 1200, 'x' ) }.with_close() );
+      test.execute( ExpectMessage<SmallSegmentSender> {}.with_seqno( isn + 1 ).with_payload_size( 500 ) );
+      test.execute( ExpectMessage<SmallSegmentSender> {}.with_seqno( isn + 501 ).with_payload_size( 500 ) );
+      test.execute( ExpectMessage<SmallSegmentSender> {}.with_payload_size( 200 ).with_fin( true ) );
+      test.execute( ExpectNoSegment<SmallSegmentSender> {} );
+      test.execute( AckReceived<SmallSegmentSender> { Wrap32 { isn + 1202 } }.with_win( 60000 ) );
+      test.execute( ExpectSeqnosInFlight<SmallSegmentSender> { 0 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Fixed RTO by default, but RTT is still estimated", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectSmoothedRTT { {} } );
+      test.execute( Tick { 40 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRTT { 40 } );
+      test.execute( ExpectRTTVariance { 20 } );
+      test.execute( ExpectRTO { TCPConfig::TIMEOUT_DFLT } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.adaptive_rt_timeout = true;
+      cfg.rt_timeout_min = 10;
+      cfg.rt_timeout_max = 300;
+
+      TCPSenderTestHarness test { "RTO follows SRTT and RTTVAR", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( ExpectRTO { TCPConfig::TIMEOUT_DFLT } );
+      test.execute( Tick { 50 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      // First sample: SRTT = 50, RTTVAR = 25, RTO = SRTT + 4 * RTTVAR
+      test.execute( ExpectSmoothedRTT { 50 } );
+      test.execute( ExpectRTTVariance { 25 } );
+      test.execute( ExpectRTO { 150 } );
+
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { 30 } );
+      test.execute( AckReceived { Wrap32 { isn + 4 } } );
+      // RTTVAR = 3/4 * 25 + 1/4 * |50 - 30|, SRTT = 7/8 * 50 + 1/8 * 30
+      test.execute( ExpectSmoothedRTT { 47 } );
+      test.execute( ExpectRTTVariance { 23 } );
+      test.execute( ExpectRTO { 142 } );
+
+      test.execute( Push { "def" } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( Tick { 141 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      // Backoff doubles the RTO, up to the maximum
+      test.execute( ExpectRTO { 284 } );
+      test.execute( Tick { 284 } );
+      test.execute( ExpectMessage {}.with_data( "def" ) );
+      test.execute( ExpectRTO { 300 } );
+      // Karn: the ACK of a retransmitted segment gives no sample
+      test.execute( Tick { 5 } );
+      test.execute( AckReceived { Wrap32 { isn + 7 } } );
+      test.execute( ExpectSmoothedRTT { 47 } );
+      test.execute( ExpectRTO { 142 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.adaptive_rt_timeout = true;
+
+      TCPSenderTestHarness test { "Computed RTO is clamped to the minimum", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 2 } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSmoothedRTT { 2 } );
+      test.execute( ExpectRTO { TCPConfig::MIN_TIMEOUT_DFLT } );
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+      test.execute( Tick { TCPConfig::MIN_TIMEOUT_DFLT } );
+      test.execute( ExpectMessage {}.with_data( "abc" ) );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Several losses in one window: only the holes are resent", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      // Eight segments: A=1 B=5 C=9 D=13 E=17 F=21 G=25 H=29, ending at 33
+      for ( const string data : { "AAAA", "BBBB", "CCCC", "DDDD", "EEEE", "FFFF", "GGGG", "HHHH" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      // B, D and F are lost; everything else arrives
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ).with_sack( isn + 9, isn + 13 ) );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }
+                      .with_win( 1000 )
+                      .with_sack( isn + 17, isn + 21 )
+                      .with_sack( isn + 9, isn + 13 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 5 } }
+                      .with_win( 1000 )
+                      .with_sack( isn + 25, isn + 29 )
+                      .with_sack( isn + 9, isn + 13 )
+                      .with_sack( isn + 17, isn + 21 ) );
+      test.execute( ExpectMessage {}.with_data( "BBBB" ).with_seqno( isn + 5 ) );
+      test.execute( ExpectNoSegment {} );
+      // H arrives: D now has three SACKed segments above it, so it is lost too
+      test.execute( AckReceived { Wrap32 { isn + 5 } }
+                      .with_win( 1000 )
+                      .with_sack( isn + 25, isn + 33 )
+                      .with_sack( isn + 9, isn + 13 )
+                      .with_sack( isn + 17, isn + 21 ) );
+      test.execute( ExpectMessage {}.with_data( "DDDD" ).with_seqno( isn + 13 ) );
+      test.execute( ExpectNoSegment {} );
+      // The resent B fills the first hole; D is already on its way
+      test.execute( AckReceived { Wrap32 { isn + 13 } }
+                      .with_win( 1000 )
+                      .with_sack( isn + 17, isn + 21 )
+                      .with_sack( isn + 25, isn + 33 ) );
+      test.execute( ExpectNoSegment {} );
+      // Partial ACK past D: F is the only hole left
+      test.execute( AckReceived { Wrap32 { isn + 21 } }.with_win( 1000 ).with_sack( isn + 25, isn + 33 ) );
+      test.execute( ExpectMessage {}.with_data( "FFFF" ).with_seqno( isn + 21 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 33 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Every other segment lost: each hole is resent once, as it becomes lost", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      // Twenty segments, the k-th at isn + 1 + 4k
+      const auto segment = []( uint32_t k ) { return string( 4, static_cast<char>( 'a' + k ) ); };
+      for ( uint32_t k = 0; k < 20; k++ ) {
+        test.execute( Push { segment( k ) } );
+        test.execute( ExpectMessage {}.with_data( segment( k ) ) );
+      }
+      // The odd ones are lost; the SACK of the (j+3)-th even one shows the j-th odd one lost
+      test.execute( AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ) );
+      for ( uint32_t k = 2; k < 20; k += 2 ) {
+        test.execute(
+          AckReceived { Wrap32 { isn + 5 } }.with_win( 1000 ).with_sack( isn + 1 + 4 * k, isn + 5 + 4 * k ) );
+        if ( k >= 6 ) {
+          test.execute( ExpectMessage {}.with_data( segment( k - 5 ) ).with_seqno( isn + 1 + 4 * ( k - 5 ) ) );
+        }
+        test.execute( ExpectNoSegment {} );
+      }
+      // The three holes left are too near the top to count as lost: partial ACKs draw them out
+      for ( uint32_t k = 15; k < 20; k += 2 ) {
+        test.execute( AckReceived { Wrap32 { isn + 1 + 4 * k } }.with_win( 1000 ) );
+        test.execute( ExpectMessage {}.with_data( segment( k ) ).with_seqno( isn + 1 + 4 * k ) );
+        test.execute( ExpectNoSegment {} );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 81 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectNoSegment {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
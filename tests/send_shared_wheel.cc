@@ -0,0 +1,80 @@
+#include "byte_stream.hh"
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "timing_wheel.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // Many senders on one wheel: advancing it wakes only those whose RTO expired
+    {
+      const size_t N = 100;
+      TCPConfig cfg;
+      const uint64_t rto = cfg.rt_timeout;
+      TimingWheel wheel;
+      vector<TCPSender> senders;
+      vector<ByteStream> streams;
+      vector<Wrap32> isns;
+      for ( size_t i = 0; i < N; i++ ) {
+        isns.emplace_back( static_cast<uint32_t>( rd() ) );
+        cfg.fixed_isn = isns.back();
+        senders.emplace_back( cfg );
+        streams.emplace_back( cfg.send_capacity );
+      }
+      for ( size_t i = 0; i < N; i++ ) {
+        senders[i].attach( wheel, i );
+        senders[i].push( streams[i].reader() );
+        test_should_be( senders[i].maybe_send().has_value(), true );
+      }
+      // Every other SYN is acknowledged, which disarms its sender's timer
+      wheel.advance( 10 );
+      for ( size_t i = 0; i < N; i += 2 ) {
+        senders[i].receive( { isns[i] + 1, 1000 } );
+      }
+      test_should_be( wheel.size(), N / 2 );
+
+      test_should_be( wheel.advance( rto - 11 ).size(), size_t { 0 } );
+      for ( uint64_t retransmissions = 1; retransmissions <= 3; retransmissions++ ) {
+        const vector<uint64_t> woken = wheel.advance( 1 );
+        test_should_be( woken.size(), N / 2 );
+        for ( const uint64_t i : woken ) {
+          test_should_be( i % 2, uint64_t { 1 } );
+          senders[i].wake();
+          const optional<TCPSenderMessage> retx = senders[i].maybe_send();
+          test_should_be( retx.has_value() && retx->SYN && retx->seqno == isns[i], true );
+          test_should_be( senders[i].consecutive_retransmissions(), retransmissions );
+        }
+        // The RTO doubles each time
+        test_should_be( wheel.advance( ( rto << retransmissions ) - 1 ).size(), size_t { 0 } );
+      }
+
+      // A sender that was never woken keeps time with the wheel anyway
+      streams[0].writer().push( "hello" );
+      senders[0].push( streams[0].reader() );
+      const optional<TCPSenderMessage> data = senders[0].maybe_send();
+      test_should_be( data.has_value(), true );
+      test_should_be( uint64_t { data->TSval.value() }, wheel.now_ms() );
+      test_should_be( wheel.size(), N / 2 + 1 );
+      senders[0].receive( { isns[0] + 6, 1000 } );
+      test_should_be( wheel.size(), N / 2 );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
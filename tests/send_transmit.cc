@@ -167,6 +167,32 @@ int main()
       test.execute( ExpectSeqno { Wrap32 { isn + 1 + 3 } } );
     }
 
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+      cfg.mss = 4;
+
+      TCPSenderTestHarness test { "Draining ready segments in one call", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abcdefghijklmn" } );
+      test.execute( ExpectBurst { { "abcd", "efgh" } }.with_batch_capacity( 2 ) );
+      test.execute( ExpectBurst { { "ijkl", "mn" } }.with_batch_capacity( 8 ) );
+      test.execute( ExpectBurst { {} }.with_batch_capacity( 8 ) );
+      test.execute( ExpectSeqnosInFlight { 14 } );
+      test.execute( Push { "opqrstu" } );
+      test.execute( ExpectBurst { { "opqr", "stu" } } );
+      test.execute( ExpectBurst { {} } );
+      test.execute( ExpectNoSegment {} );
+      // Drained segments are outstanding like any other
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectBurst { { "abcd" } } );
+      test.execute( AckReceived { Wrap32 { isn + 22 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+    }
+
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return 1;
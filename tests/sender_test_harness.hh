@@ -9,12 +9,17 @@
 #include <optional>
 #include <sstream>
 #include <utility>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
-using StreamAndSender = std::pair<ByteStream, TCPSender>;
+// The stream and the sender under test, whose policy the test picks
+template<typename Sender>
+using BasicStreamAndSender = std::pair<ByteStream, Sender>;
 
-static std::string to_string( const TCPSenderMessage& msg )
+using StreamAndSender = BasicStreamAndSender<TCPSender>;
+
+inline std::string to_string( const TCPSenderMessage& msg )
 {
   std::ostringstream o;
   o << "(";
@@ -32,12 +37,13 @@ static std::string to_string( const TCPSenderMessage& msg )
   return o.str();
 }
 
-struct ExpectSeqno : public ExpectNumber<StreamAndSender, Wrap32>
+template<typename Sender = TCPSender>
+struct ExpectSeqno : public ExpectNumber<BasicStreamAndSender<Sender>, Wrap32>
 {
-  using ExpectNumber::ExpectNumber;
+  explicit ExpectSeqno( Wrap32 num ) : ExpectNumber<BasicStreamAndSender<Sender>, Wrap32>( num ) {}
   std::string name() const override { return "send_empty_message().seqno"; }
 
-  Wrap32 value( StreamAndSender& ss ) const override
+  Wrap32 value( BasicStreamAndSender<Sender>& ss ) const override
   {
     auto seg = ss.second.send_empty_message();
     if ( seg.sequence_length() ) {
@@ -47,17 +53,87 @@ struct ExpectSeqno : public ExpectNumber<StreamAndSender, Wrap32>
   }
 };
 
-struct ExpectSeqnosInFlight : public ExpectNumber<StreamAndSender, uint64_t>
+template<typename Sender = TCPSender>
+struct ExpectSeqnosInFlight : public ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>
 {
-  using ExpectNumber::ExpectNumber;
+  explicit ExpectSeqnosInFlight( uint64_t num ) : ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>( num ) {}
   std::string name() const override { return "sequence_numbers_in_flight"; }
-  uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_in_flight(); }
+  uint64_t value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.sequence_numbers_in_flight(); }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectCongestionWindow : public ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>
+{
+  explicit ExpectCongestionWindow( uint64_t num ) : ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>( num ) {}
+  std::string name() const override { return "congestion_window"; }
+  uint64_t value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.congestion_window(); }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectSmoothedRTT : public ExpectNumber<BasicStreamAndSender<Sender>, std::optional<uint64_t>>
+{
+  explicit ExpectSmoothedRTT( std::optional<uint64_t> num )
+    : ExpectNumber<BasicStreamAndSender<Sender>, std::optional<uint64_t>>( num )
+  {}
+  std::string name() const override { return "srtt_ms"; }
+  std::optional<uint64_t> value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.srtt_ms(); }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectRTTVariance : public ExpectNumber<BasicStreamAndSender<Sender>, std::optional<uint64_t>>
+{
+  explicit ExpectRTTVariance( std::optional<uint64_t> num )
+    : ExpectNumber<BasicStreamAndSender<Sender>, std::optional<uint64_t>>( num )
+  {}
+  std::string name() const override { return "rttvar_ms"; }
+  std::optional<uint64_t> value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.rttvar_ms(); }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectRTO : public ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>
+{
+  explicit ExpectRTO( uint64_t num ) : ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>( num ) {}
+  std::string name() const override { return "rto_ms"; }
+  uint64_t value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.rto_ms(); }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectNextSendTime : public ExpectNumber<BasicStreamAndSender<Sender>, std::optional<uint64_t>>
+{
+  explicit ExpectNextSendTime( std::optional<uint64_t> num )
+    : ExpectNumber<BasicStreamAndSender<Sender>, std::optional<uint64_t>>( num )
+  {}
+  std::string name() const override { return "next_send_time"; }
+  std::optional<uint64_t> value( BasicStreamAndSender<Sender>& ss ) const override
+  {
+    return ss.second.next_send_time();
+  }
 };
 
-struct ExpectNoSegment : public Expectation<StreamAndSender>
+template<typename Sender = TCPSender>
+struct ExpectUnsentBytes : public ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>
+{
+  explicit ExpectUnsentBytes( uint64_t num ) : ExpectNumber<BasicStreamAndSender<Sender>, uint64_t>( num ) {}
+  std::string name() const override { return "unsent_bytes"; }
+  uint64_t value( BasicStreamAndSender<Sender>& ss ) const override
+  {
+    return ss.second.unsent_bytes( ss.first.reader() );
+  }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectWritable : public ExpectBool<BasicStreamAndSender<Sender>>
+{
+  explicit ExpectWritable( bool value ) : ExpectBool<BasicStreamAndSender<Sender>>( value ) {}
+  std::string name() const override { return "writable"; }
+  bool value( BasicStreamAndSender<Sender>& ss ) const override { return ss.second.writable( ss.first.reader() ); }
+};
+
+template<typename Sender = TCPSender>
+struct ExpectNoSegment : public Expectation<BasicStreamAndSender<Sender>>
 {
   std::string description() const override { return "nothing to send"; }
-  void execute( StreamAndSender& ss ) const override
+  void execute( BasicStreamAndSender<Sender>& ss ) const override
   {
     const auto msg = ss.second.maybe_send();
     if ( msg.has_value() ) {
@@ -66,7 +142,8 @@ struct ExpectNoSegment : public Expectation<StreamAndSender>
   }
 };
 
-struct Push : public Action<StreamAndSender>
+template<typename Sender = TCPSender>
+struct Push : public Action<BasicStreamAndSender<Sender>>
 {
   std::string data_;
   bool close_ {};
@@ -85,7 +162,7 @@ struct Push : public Action<StreamAndSender>
     return "push \"" + Printer::prettify( data_ ) + "\" to stream" + ( close_ ? ", close it" : "" )
            + ", then push to TCPSender";
   }
-  void execute( StreamAndSender& ss ) const override
+  void execute( BasicStreamAndSender<Sender>& ss ) const override
   {
     if ( not data_.empty() ) {
       ss.first.writer().push( data_ );
@@ -103,7 +180,15 @@ struct Push : public Action<StreamAndSender>
   }
 };
 
-struct Tick : public Action<StreamAndSender>
+template<typename Sender = TCPSender>
+struct Flush : public Action<BasicStreamAndSender<Sender>>
+{
+  std::string description() const override { return "flush TCPSender"; }
+  void execute( BasicStreamAndSender<Sender>& ss ) const override { ss.second.flush( ss.first.reader() ); }
+};
+
+template<typename Sender = TCPSender>
+struct Tick : public Action<BasicStreamAndSender<Sender>>
 {
   uint64_t ms_;
   std::optional<bool> max_retx_exceeded_ {};
@@ -126,7 +211,7 @@ struct Tick : public Action<StreamAndSender>
     return desc.str();
   }
 
-  void execute( StreamAndSender& ss ) const override
+  void execute( BasicStreamAndSender<Sender>& ss ) const override
   {
     ss.second.tick( ms_ );
     if ( max_retx_exceeded_.has_value()
@@ -145,7 +230,8 @@ struct Tick : public Action<StreamAndSender>
   }
 };
 
-struct Receive : public Action<StreamAndSender>
+template<typename Sender = TCPSender>
+struct Receive : public Action<BasicStreamAndSender<Sender>>
 {
   TCPReceiverMessage msg_;
   bool push_ = true;
@@ -154,7 +240,11 @@ struct Receive : public Action<StreamAndSender>
   std::string description() const override
   {
     std::ostringstream desc;
-    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size << ")";
+    desc << "receive(ack=" << to_string( msg_.ackno ) << ", win=" << msg_.window_size;
+    for ( const auto& block : msg_.SACK ) {
+      desc << ", sack=[" << to_string( block.begin ) << ", " << to_string( block.end ) << ")";
+    }
+    desc << ")";
     if ( push_ ) {
       desc << ", then push stream to TCPSender";
     }
@@ -167,7 +257,31 @@ struct Receive : public Action<StreamAndSender>
     return *this;
   }
 
-  void execute( StreamAndSender& ss ) const override
+  Receive& with_mss( uint16_t mss )
+  {
+    msg_.MSS = mss;
+    return *this;
+  }
+
+  Receive& with_tsecr( uint32_t tsecr )
+  {
+    msg_.TSecr = tsecr;
+    return *this;
+  }
+
+  Receive& with_ece()
+  {
+    msg_.ECE = true;
+    return *this;
+  }
+
+  Receive& with_sack( Wrap32 begin, Wrap32 end )
+  {
+    msg_.SACK.push_back( { begin, end } );
+    return *this;
+  }
+
+  void execute( BasicStreamAndSender<Sender>& ss ) const override
   {
     ss.second.receive( msg_ );
     if ( push_ ) {
@@ -182,23 +296,28 @@ struct Receive : public Action<StreamAndSender>
   }
 };
 
-struct AckReceived : public Receive
+template<typename Sender = TCPSender>
+struct AckReceived : public Receive<Sender>
 {
-  explicit AckReceived( Wrap32 ackno ) : Receive( { ackno, DEFAULT_TEST_WINDOW } ) {}
+  explicit AckReceived( Wrap32 ackno ) : Receive<Sender>( { ackno, DEFAULT_TEST_WINDOW } ) {}
 };
 
-struct Close : public Push
+template<typename Sender = TCPSender>
+struct Close : public Push<Sender>
 {
-  Close() : Push( "" ) { with_close(); }
+  Close() : Push<Sender>( "" ) { this->with_close(); }
 };
 
-struct ExpectMessage : public Expectation<StreamAndSender>
+template<typename Sender = TCPSender>
+struct ExpectMessage : public Expectation<BasicStreamAndSender<Sender>>
 {
   std::optional<bool> syn {};
   std::optional<bool> fin {};
   std::optional<Wrap32> seqno {};
   std::optional<std::string> data {};
   std::optional<size_t> payload_size {};
+  std::optional<bool> cwr {};
+  std::optional<uint8_t> ecn {};
 
   ExpectMessage& with_syn( bool syn_ )
   {
@@ -239,6 +358,18 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     return *this;
   }
 
+  ExpectMessage& with_cwr( bool cwr_ )
+  {
+    cwr = cwr_;
+    return *this;
+  }
+
+  ExpectMessage& with_ecn( uint8_t ecn_ )
+  {
+    ecn = ecn_;
+    return *this;
+  }
+
   std::string message_description() const
   {
     std::ostringstream o;
@@ -261,12 +392,18 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() ) {
       o << ( fin.value() ? " +FIN" : " (no FIN)" );
     }
+    if ( cwr.has_value() ) {
+      o << ( cwr.value() ? " +CWR" : " (no CWR)" );
+    }
+    if ( ecn.has_value() ) {
+      o << " ecn=" << static_cast<int>( ecn.value() );
+    }
     return o.str();
   }
 
   std::string description() const override { return "message sent with" + message_description(); }
 
-  void execute( StreamAndSender& ss ) const override
+  void execute( BasicStreamAndSender<Sender>& ss ) const override
   {
     if ( payload_size.has_value() and data.has_value() and payload_size.value() != data.value().size() ) {
       throw std::runtime_error( "inconsistent test: invalid ExpectMessage" );
@@ -284,13 +421,19 @@ struct ExpectMessage : public Expectation<StreamAndSender>
     if ( fin.has_value() and seg.FIN != fin.value() ) {
       throw ExpectationViolation( "FIN flag", fin.value(), seg.FIN );
     }
+    if ( cwr.has_value() and seg.CWR != cwr.value() ) {
+      throw ExpectationViolation( "CWR flag", cwr.value(), seg.CWR );
+    }
+    if ( ecn.has_value() and seg.ECN != ecn.value() ) {
+      throw ExpectationViolation( "ECN codepoint", static_cast<int>( ecn.value() ), static_cast<int>( seg.ECN ) );
+    }
     if ( seqno.has_value() and seg.seqno != seqno.value() ) {
       throw ExpectationViolation( "sequence number", seqno.value(), seg.seqno );
     }
     if ( payload_size.has_value() and seg.payload.size() != payload_size.value() ) {
       throw ExpectationViolation( "payload_size", payload_size.value(), seg.payload.size() );
     }
-    if ( seg.payload.size() > TCPConfig::MAX_PAYLOAD_SIZE ) {
+    if ( seg.payload.size() > ss.second.max_payload_size() ) {
       throw ExpectationViolation( "payload has length (" + std::to_string( seg.payload.size() )
                                   + ") greater than the maximum" );
     }
@@ -301,12 +444,66 @@ struct ExpectMessage : public Expectation<StreamAndSender>
   }
 };
 
-class TCPSenderTestHarness : public TestHarness<StreamAndSender>
+// The payloads of a drained burst, sent either through maybe_send_batch() or transmit()
+template<typename Sender = TCPSender>
+struct ExpectBurst : public Expectation<BasicStreamAndSender<Sender>>
+{
+  std::vector<std::string> data_;
+  std::optional<size_t> batch_capacity_ {}; // maybe_send_batch() into this many slots, or transmit() if empty
+
+  explicit ExpectBurst( std::vector<std::string> data ) : data_( std::move( data ) ) {}
+
+  ExpectBurst& with_batch_capacity( size_t capacity )
+  {
+    batch_capacity_ = capacity;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    std::ostringstream desc;
+    if ( batch_capacity_.has_value() ) {
+      desc << "maybe_send_batch() with room for " << batch_capacity_.value() << " gives payloads [";
+    } else {
+      desc << "transmit() gives payloads [";
+    }
+    for ( const auto& data : data_ ) {
+      desc << " \"" << Printer::prettify( data ) << "\"";
+    }
+    desc << " ]";
+    return desc.str();
+  }
+
+  void execute( BasicStreamAndSender<Sender>& ss ) const override
+  {
+    std::vector<std::string> sent;
+    if ( batch_capacity_.has_value() ) {
+      std::vector<TCPSenderMessage> batch( batch_capacity_.value() );
+      const size_t count = ss.second.maybe_send_batch( batch );
+      for ( size_t i = 0; i < count; i++ ) {
+        sent.emplace_back( static_cast<std::string_view>( batch[i].payload ) );
+      }
+    } else {
+      const size_t count = ss.second.transmit(
+        [&]( const TCPSenderMessage& msg ) { sent.emplace_back( static_cast<std::string_view>( msg.payload ) ); } );
+      if ( count != sent.size() ) {
+        throw ExpectationViolation( "transmit() count", sent.size(), count );
+      }
+    }
+    if ( sent != data_ ) {
+      throw ExpectationViolation( "sent " + std::to_string( sent.size() ) + " segments, expected "
+                                  + std::to_string( data_.size() ) + " with the given payloads" );
+    }
+  }
+};
+
+template<typename Sender = TCPSender>
+class TCPSenderTestHarness : public TestHarness<BasicStreamAndSender<Sender>>
 {
 public:
   TCPSenderTestHarness( std::string name, TCPConfig config )
-    : TestHarness( move( name ),
-                   "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } } )
+    : TestHarness<BasicStreamAndSender<Sender>>( move( name ),
+                                                 "initial_RTO_ms=" + to_string( config.rt_timeout ),
+                                                 { ByteStream { config.send_capacity }, Sender { config } } )
   {}
 };
@@ -0,0 +1,138 @@
+#include "byte_stream.hh"
+#include "random.hh"
+#include "reassembler.hh"
+#include "stream_mux.hh"
+#include "tcp_receiver.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+string read_all( Reader& reader )
+{
+  string out;
+  read( reader, reader.bytes_buffered(), out );
+  return out;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // A lost segment holds up only the stream whose bytes it carried
+    {
+      StreamMux client;
+      StreamMux server;
+      ByteStream wire { 64000 };
+      client.outbound( 1 ).push( string( 1500, 'a' ) );
+      client.outbound( 2 ).push( string( 1500, 'b' ) );
+      client.outbound( 2 ).close();
+      client.push( wire.writer() );
+      test_should_be( wire.reader().bytes_buffered(), uint64_t { 3070 } );
+
+      // Cut the wire into segments that don't line up with the frames
+      const Wrap32 isn( rd() );
+      vector<TCPSenderMessage> segments;
+      const string bytes = read_all( wire.reader() );
+      for ( uint64_t i = 0; i < bytes.size(); i += 700 ) {
+        segments.push_back( { isn + 1 + i, false, bytes.substr( i, 700 ), false, {}, false, {} } );
+      }
+
+      TCPReceiver receiver;
+      Reassembler reassembler;
+      ByteStream inbound { 64000 };
+      const auto arrives = [&]( const TCPSenderMessage& segment ) {
+        const optional<uint64_t> index = receiver.stream_index( segment, reassembler );
+        receiver.receive( segment, reassembler, inbound.writer() );
+        if ( index.has_value() ) {
+          server.segment_received( index.value(), segment.payload );
+        }
+        server.receive( inbound.reader() );
+      };
+      arrives( { isn, true, {}, false, {}, false, {} } );
+
+      // The first segment is lost; the rest arrive
+      for ( size_t i = 1; i < segments.size(); i++ ) {
+        arrives( segments[i] );
+      }
+      test_should_be( inbound.reader().bytes_buffered(), uint64_t { 0 } );
+      test_should_be( server.inbound( 1 ).bytes_buffered(), uint64_t { 0 } );
+      test_should_be( server.inbound( 2 ).bytes_buffered(), uint64_t { 386 } );
+      test_should_be( read_all( server.inbound( 2 ) ) == string( 386, 'b' ), true );
+
+      // The retransmission fills the hole
+      arrives( segments[0] );
+      test_should_be( read_all( server.inbound( 1 ) ) == string( 1500, 'a' ), true );
+      test_should_be( read_all( server.inbound( 2 ) ) == string( 1114, 'b' ), true );
+      test_should_be( server.inbound( 1 ).is_finished(), false );
+      test_should_be( server.inbound( 2 ).is_finished(), true );
+    }
+
+    // Each stream sends only as much as the peer has granted it
+    {
+      MuxConfig config;
+      config.stream_window = 2000;
+      StreamMux client { config };
+      StreamMux server { config };
+      ByteStream there { 64000 };
+      ByteStream back { 64000 };
+
+      client.outbound( 3 ).push( string( 2000, 'x' ) );
+      client.push( there.writer() );
+      test_should_be( client.send_credit( 3 ), uint64_t { 0 } );
+      client.outbound( 3 ).push( string( 1000, 'y' ) );
+      client.outbound( 4 ).push( "other streams still flow" );
+      client.push( there.writer() );
+      server.receive( there.reader() );
+      test_should_be( server.inbound( 3 ).bytes_buffered(), uint64_t { 2000 } );
+      test_should_be( read_all( server.inbound( 4 ) ) == string( "other streams still flow" ), true );
+
+      // Credit comes back once the reader has freed half the window
+      string first;
+      read( server.inbound( 3 ), 999, first );
+      server.push( back.writer() );
+      test_should_be( back.reader().bytes_buffered(), uint64_t { 0 } );
+      read( server.inbound( 3 ), 1, first );
+      server.push( back.writer() );
+      client.receive( back.reader() );
+      test_should_be( client.send_credit( 3 ), uint64_t { 1000 } );
+      client.push( there.writer() );
+      server.receive( there.reader() );
+      test_should_be( read_all( server.inbound( 3 ) ) == string( 1000, 'x' ) + string( 1000, 'y' ), true );
+    }
+
+    // Streams close independently, with or without data
+    {
+      StreamMux client;
+      StreamMux server;
+      ByteStream wire { 64000 };
+      client.outbound( 0 ).close();
+      client.outbound( 5 ).push( "last words" );
+      client.outbound( 5 ).close();
+      client.push( wire.writer() );
+      server.receive( wire.reader() );
+      test_should_be( server.inbound( 0 ).is_finished(), true );
+      test_should_be( read_all( server.inbound( 5 ) ) == string( "last words" ), true );
+      test_should_be( server.inbound( 5 ).is_finished(), true );
+      test_should_be( server.inbound( 6 ).is_finished(), false );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+#include "address.hh"
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "network_interface.hh"
+#include "tcp_over_ip.hh"
+#include "tcp_peer.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// One end of the connection: a peer behind its network interface
+struct Host
+{
+  TCPPeer peer;
+  NetworkInterface interface;
+  Address address;
+  uint16_t port;
+};
+
+// Hand everything the peer has to send to its interface, in datagrams addressed to `to`
+void send_all( Host& from, const Host& to )
+{
+  while ( auto message = from.peer.maybe_send() ) {
+    const TCPSegment segment { from.port, to.port, std::move( message.value() ) };
+    from.interface.send_datagram(
+      wrap_tcp_in_ip( segment, from.address.ipv4_numeric(), to.address.ipv4_numeric() ), to.address );
+  }
+}
+
+// Move the frames each interface has queued to the other until both are quiet, passing the TCP
+// segments that arrive up to the peers; returns the segments that reached `b`
+vector<TCPSegment> carry( Host& a, Host& b )
+{
+  vector<TCPSegment> delivered;
+  const auto deliver = []( const EthernetFrame& frame, Host& to ) -> optional<TCPSegment> {
+    const optional<InternetDatagram> datagram = to.interface.recv_frame( frame );
+    if ( !datagram.has_value() ) {
+      return {};
+    }
+    optional<TCPSegment> segment = unwrap_tcp_in_ip( datagram.value() );
+    if ( !segment.has_value() ) {
+      throw runtime_error( "segment didn't survive the trip through IP" );
+    }
+    to.peer.receive( segment->message );
+    return segment;
+  };
+  for ( bool moved = true; moved; ) {
+    moved = false;
+    while ( auto frame = a.interface.maybe_send() ) {
+      moved = true;
+      if ( auto segment = deliver( frame.value(), b ) ) {
+        delivered.push_back( std::move( segment.value() ) );
+      }
+    }
+    while ( auto frame = b.interface.maybe_send() ) {
+      moved = true;
+      deliver( frame.value(), a );
+    }
+  }
+  return delivered;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    // A CE mark made by a congested interface reaches the receiver, and comes back to the sender as ECE
+    {
+      TCPConfig cfg;
+      cfg.ecn = true;
+      cfg.mss = 100;
+      const Address client_ip( "10.0.0.1", 0 );
+      Host client { TCPPeer { cfg }, NetworkInterface { { 2, 0, 0, 0, 0, 1 }, client_ip }, client_ip, 5000 };
+      const Address server_ip( "10.0.0.2", 0 );
+      Host server { TCPPeer { cfg }, NetworkInterface { { 2, 0, 0, 0, 0, 2 }, server_ip }, server_ip, 80 };
+
+      client.peer.connect();
+      send_all( client, server );
+      const vector<TCPSegment> syn = carry( client, server );
+      test_should_be( syn.size(), size_t { 1 } );
+      test_should_be( syn[0].message.sender.SYN, true );
+      test_should_be( syn[0].message.sender.ECN, IPv4Header::ECN_NOT_ECT );
+      send_all( server, client );
+      carry( server, client );
+      send_all( client, server );
+      carry( client, server );
+      test_should_be( client.peer.state() == TCPState::ESTABLISHED, true );
+      test_should_be( server.peer.state() == TCPState::ESTABLISHED, true );
+
+      // Two segments at once: the second finds the first still queued, past the threshold
+      client.interface.set_ecn_marking_threshold( 1 );
+      client.peer.outbound_writer().push( string( 200, 'x' ) );
+      client.peer.push();
+      send_all( client, server );
+      const vector<TCPSegment> data = carry( client, server );
+      test_should_be( data.size(), size_t { 2 } );
+      test_should_be( data[0].message.sender.ECN, IPv4Header::ECN_ECT0 );
+      test_should_be( data[1].message.sender.ECN, IPv4Header::ECN_CE );
+      test_should_be( server.peer.inbound_reader().bytes_buffered(), uint64_t { 200 } );
+
+      send_all( server, client );
+      const vector<TCPSegment> ack = carry( server, client );
+      test_should_be( ack.empty(), false );
+      test_should_be( ack.back().message.receiver.ECE, true );
+
+      // The sender answers with CWR on its next segment of new data
+      client.peer.outbound_writer().push( "y" );
+      client.peer.push();
+      send_all( client, server );
+      const vector<TCPSegment> cwr = carry( client, server );
+      test_should_be( cwr.size(), size_t { 1 } );
+      test_should_be( cwr[0].message.sender.CWR, true );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
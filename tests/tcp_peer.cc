@@ -0,0 +1,237 @@
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Carry everything `from` has to send over the wire format to `to`, dropping the segments `drop`
+// picks; returns the messages sent
+template<typename Drop>
+vector<TCPMessage> exchange( TCPPeer& from, TCPPeer& to, Drop&& drop )
+{
+  vector<TCPMessage> sent;
+  while ( auto message = from.maybe_send() ) {
+    sent.push_back( message.value() );
+    TCPSegment seg;
+    seg.message = std::move( message.value() );
+    IPv4Header ip;
+    ip.len = static_cast<uint16_t>( IPv4Header::LENGTH + seg.header().size() + seg.message.sender.payload.size() );
+    seg.compute_checksum( ip.pseudo_checksum() );
+
+    TCPSegment received;
+    Parser p { serialize( seg ) };
+    received.parse( p, ip.pseudo_checksum() );
+    if ( p.has_error() ) {
+      throw runtime_error( "segment didn't survive the wire format" );
+    }
+    if ( !drop() ) {
+      to.receive( received.message );
+    }
+  }
+  return sent;
+}
+
+vector<TCPMessage> exchange( TCPPeer& from, TCPPeer& to )
+{
+  return exchange( from, to, [] { return false; } );
+}
+
+string read_all( Reader& reader )
+{
+  string out;
+  read( reader, reader.bytes_buffered(), out );
+  return out;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // Handshake, data both ways with the ACKs riding along, and an orderly close
+    {
+      TCPConfig cfg;
+      TCPPeer client { cfg };
+      TCPPeer server { cfg };
+      test_should_be( server.state() == TCPState::LISTEN, true );
+
+      client.connect();
+      test_should_be( client.state() == TCPState::SYN_SENT, true );
+      test_should_be( exchange( client, server ).size(), size_t { 1 } );
+      test_should_be( server.state() == TCPState::SYN_RECEIVED, true );
+      const vector<TCPMessage> syn_ack = exchange( server, client );
+      test_should_be( syn_ack.size(), size_t { 1 } );
+      test_should_be( syn_ack[0].sender.SYN && syn_ack[0].receiver.ackno.has_value(), true );
+      test_should_be( client.state() == TCPState::ESTABLISHED, true );
+      exchange( client, server );
+      test_should_be( server.state() == TCPState::ESTABLISHED, true );
+
+      // The server's reply, written before the request arrives, carries the request's ACK
+      client.outbound_writer().push( "request" );
+      client.push();
+      server.outbound_writer().push( "reply" );
+      exchange( client, server );
+      const vector<TCPMessage> replies = exchange( server, client );
+      test_should_be( replies.size(), size_t { 1 } );
+      test_should_be( static_cast<string_view>( replies[0].sender.payload ) == "reply", true );
+      test_should_be( read_all( server.inbound_reader() ) == "request", true );
+      test_should_be( read_all( client.inbound_reader() ) == "reply", true );
+      test_should_be( client.sender().sequence_numbers_in_flight(), uint64_t { 0 } );
+
+      // The client closes first, so it's the one that lingers
+      client.outbound_writer().close();
+      client.push();
+      exchange( client, server );
+      test_should_be( server.state() == TCPState::CLOSE_WAIT, true );
+      exchange( server, client );
+      test_should_be( client.state() == TCPState::FIN_WAIT_2, true );
+      server.outbound_writer().close();
+      server.push();
+      test_should_be( server.state() == TCPState::LAST_ACK, true );
+      exchange( server, client );
+      test_should_be( client.state() == TCPState::TIME_WAIT, true );
+      exchange( client, server );
+      test_should_be( server.state() == TCPState::CLOSED, true );
+      test_should_be( server.active(), false );
+      test_should_be( client.active(), true );
+      client.tick( 10 * cfg.rt_timeout - 1 );
+      test_should_be( client.active(), true );
+      client.tick( 1 );
+      test_should_be( client.state() == TCPState::CLOSED, true );
+      test_should_be( client.inbound_reader().is_finished(), true );
+      test_should_be( server.inbound_reader().is_finished(), true );
+    }
+
+    // A bulk transfer gets through intact despite a lossy path
+    {
+      TCPConfig cfg;
+      cfg.congestion_control = CongestionControlAlgorithm::RENO;
+      TCPPeer client { cfg };
+      TCPPeer server { cfg };
+      string data( 200000, 0 );
+      for ( auto& c : data ) {
+        c = static_cast<char>( rd() );
+      }
+      uint64_t segments = 0;
+      const auto lossy = [&] { return ++segments % 7 == 0; };
+
+      client.connect();
+      string received;
+      size_t written = 0;
+      for ( int round = 0; round < 10000 && ( client.active() || server.active() ); round++ ) {
+        if ( written < data.size() ) {
+          const size_t n = min( data.size() - written, client.outbound_writer().available_capacity() );
+          client.outbound_writer().push( data.substr( written, n ) );
+          written += n;
+          if ( written == data.size() ) {
+            client.outbound_writer().close();
+          }
+          client.push();
+        }
+        exchange( client, server, lossy );
+        received += read_all( server.inbound_reader() );
+        if ( server.inbound_reader().is_finished() && !server.outbound_writer().is_closed() ) {
+          server.outbound_writer().close();
+          server.push();
+        }
+        exchange( server, client, lossy );
+        client.tick( 100 );
+        server.tick( 100 );
+      }
+      test_should_be( received.size(), data.size() );
+      test_should_be( received == data, true );
+      test_should_be( client.active() || server.active(), false );
+    }
+
+    // A listening peer that corks its data still answers a SYN with its own
+    {
+      TCPConfig cfg;
+      cfg.coalescing = Coalescing::CORK;
+      TCPPeer client { cfg };
+      TCPPeer server { cfg };
+      server.outbound_writer().push( "hi" );
+      client.connect();
+      exchange( client, server );
+      const vector<TCPMessage> syn_ack = exchange( server, client );
+      test_should_be( syn_ack.size(), size_t { 1 } );
+      test_should_be( syn_ack[0].sender.SYN && syn_ack[0].receiver.ackno.has_value(), true );
+      test_should_be( syn_ack[0].sender.payload.empty(), true );
+      test_should_be( client.state() == TCPState::ESTABLISHED, true );
+      exchange( client, server );
+      test_should_be( server.state() == TCPState::ESTABLISHED, true );
+      // Closing the stream uncorks the data, with the FIN
+      server.outbound_writer().close();
+      server.push();
+      const vector<TCPMessage> data = exchange( server, client );
+      test_should_be( data.size(), size_t { 1 } );
+      test_should_be( data[0].sender.FIN, true );
+      test_should_be( read_all( client.inbound_reader() ) == "hi", true );
+    }
+
+    // Super segments are cut to the MSS before they leave the peer
+    {
+      TCPConfig cfg;
+      cfg.super_segments = true;
+      TCPPeer client { cfg };
+      TCPPeer server { cfg };
+      client.connect();
+      exchange( client, server );
+      exchange( server, client );
+      test_should_be( client.state() == TCPState::ESTABLISHED, true );
+
+      const uint64_t mss = client.sender().mss();
+      string data( 5 * mss + 17, 0 );
+      for ( auto& c : data ) {
+        c = static_cast<char>( rd() );
+      }
+      client.outbound_writer().push( data );
+      client.push();
+      string received;
+      size_t segments = 0;
+      for ( int round = 0; round < 100 && received.size() < data.size(); round++ ) {
+        for ( const TCPMessage& message : exchange( client, server ) ) {
+          test_should_be( message.sender.payload.size() <= mss, true );
+          segments += !message.sender.payload.empty();
+        }
+        received += read_all( server.inbound_reader() );
+        exchange( server, client );
+      }
+      test_should_be( received == data, true );
+      test_should_be( segments, size_t { 6 } );
+    }
+
+    // A peer that hears nothing back gives up
+    {
+      TCPConfig cfg;
+      TCPPeer client { cfg };
+      client.connect();
+      for ( int i = 0; i < 1000 && client.active(); i++ ) {
+        client.tick( client.sender().rto_ms() );
+        while ( client.maybe_send().has_value() ) {}
+      }
+      test_should_be( client.state() == TCPState::CLOSED, true );
+      test_should_be( client.inbound_reader().has_error(), true );
+      test_should_be( client.sender().consecutive_retransmissions(), uint64_t { TCPConfig::MAX_RETX_ATTEMPTS + 1 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
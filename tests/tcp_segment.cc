@@ -0,0 +1,177 @@
+#include "checksum.hh"
+#include "ipv4_header.hh"
+#include "random.hh"
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// The internet checksum one byte at a time, straight from RFC 1071
+uint16_t reference_checksum( const string& data, uint32_t initial )
+{
+  uint64_t sum = initial;
+  for ( size_t i = 0; i < data.size(); i++ ) {
+    sum += i % 2 == 0 ? static_cast<uint64_t>( static_cast<uint8_t>( data[i] ) ) << 8 : static_cast<uint8_t>( data[i] );
+  }
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + ( sum & 0xffff );
+  }
+  return static_cast<uint16_t>( ~sum );
+}
+
+string concatenate( const vector<Buffer>& buffers )
+{
+  string out;
+  for ( const auto& buffer : buffers ) {
+    out.append( static_cast<string_view>( buffer ) );
+  }
+  return out;
+}
+
+uint32_t pseudo_checksum( size_t segment_length )
+{
+  IPv4Header ip;
+  ip.src = 0x0a000001;
+  ip.dst = 0x0a000002;
+  ip.len = static_cast<uint16_t>( IPv4Header::LENGTH + segment_length );
+  return ip.pseudo_checksum();
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // The word-at-a-time checksum agrees with the byte-at-a-time one, however the data is split
+    {
+      for ( size_t length : { 0, 1, 7, 8, 9, 63, 1000, 1461 } ) {
+        string data( length, 0 );
+        for ( auto& c : data ) {
+          c = static_cast<char>( rd() );
+        }
+        for ( size_t split : { size_t { 0 }, size_t { 1 }, size_t { 3 }, length / 2 } ) {
+          split = min( split, length );
+          InternetChecksum check { 0x1234 };
+          check.add( string_view { data }.substr( 0, split ) );
+          check.add( string_view { data }.substr( split ) );
+          test_should_be( check.value(), reference_checksum( data, 0x1234 ) );
+        }
+      }
+    }
+
+    // The header is laid out as RFC 9293 says
+    {
+      TCPSegment seg;
+      seg.sport = 1000;
+      seg.dport = 80;
+      seg.message.sender.seqno = Wrap32 { 0x01020304 };
+      seg.message.sender.SYN = true;
+      seg.message.receiver.window_size = 64000;
+      seg.message.receiver.MSS = 1000;
+      const string expected = "\x03\xe8\x00\x50\x01\x02\x03\x04\x00\x00\x00\x00\x60\x02\xfa\x00"
+                              "\x00\x00\x00\x00\x02\x04\x03\xe8"s;
+      test_should_be( seg.header() == expected, true );
+    }
+
+    // Everything survives a round trip, options included; a flipped bit doesn't
+    {
+      TCPSegment seg;
+      seg.sport = 5555;
+      seg.dport = 443;
+      TCPSenderMessage& sender = seg.message.sender;
+      TCPReceiverMessage& receiver = seg.message.receiver;
+      sender.seqno = Wrap32 { static_cast<uint32_t>( rd() ) };
+      sender.payload = string( 999, 'x' );
+      sender.FIN = true;
+      sender.TSval = 123456;
+      sender.CWR = true;
+      receiver.ackno = Wrap32 { static_cast<uint32_t>( rd() ) };
+      receiver.window_size = 4321;
+      receiver.TSecr = 654321;
+      receiver.ECE = true;
+      for ( uint32_t i = 0; i < 4; i++ ) {
+        receiver.SACK.push_back( { receiver.ackno.value() + 100 * ( i + 1 ), receiver.ackno.value() + 100 * i + 150 } );
+      }
+      const uint32_t pseudo = pseudo_checksum( 20 + 12 + 28 + 999 );
+      seg.compute_checksum( pseudo );
+      const vector<Buffer> wire = serialize( seg );
+      test_should_be( concatenate( wire ).size(), size_t { 20 + 12 + 28 + 999 } );
+
+      TCPSegment parsed;
+      {
+        Parser p { wire };
+        parsed.parse( p, pseudo );
+        test_should_be( p.has_error(), false );
+      }
+      test_should_be( parsed.sport, uint16_t { 5555 } );
+      test_should_be( parsed.dport, uint16_t { 443 } );
+      test_should_be( parsed.cksum, seg.cksum );
+      test_should_be( parsed.message.sender.seqno, sender.seqno );
+      test_should_be( parsed.message.sender.SYN, false );
+      test_should_be( parsed.message.sender.FIN, true );
+      test_should_be( parsed.message.sender.CWR, true );
+      test_should_be( parsed.message.sender.TSval.value(), uint32_t { 123456 } );
+      test_should_be( static_cast<string_view>( parsed.message.sender.payload ) == string( 999, 'x' ), true );
+      test_should_be( parsed.message.receiver.ackno.value(), receiver.ackno.value() );
+      test_should_be( parsed.message.receiver.window_size, uint16_t { 4321 } );
+      test_should_be( parsed.message.receiver.TSecr.value(), uint32_t { 654321 } );
+      test_should_be( parsed.message.receiver.ECE, true );
+      test_should_be( parsed.message.receiver.MSS.has_value(), false );
+      // Only three blocks fit next to the timestamps
+      test_should_be( parsed.message.receiver.SACK.size(), size_t { 3 } );
+      for ( size_t i = 0; i < 3; i++ ) {
+        test_should_be( parsed.message.receiver.SACK[i].begin, receiver.SACK[i].begin );
+        test_should_be( parsed.message.receiver.SACK[i].end, receiver.SACK[i].end );
+      }
+
+      string corrupted = concatenate( wire );
+      corrupted[500] ^= 0x10;
+      Parser p { vector<Buffer> { corrupted } };
+      TCPSegment rejected;
+      rejected.parse( p, pseudo );
+      test_should_be( p.has_error(), true );
+
+      // So does one addressed to someone else
+      Parser misdelivered { wire };
+      rejected.parse( misdelivered, pseudo + 1 );
+      test_should_be( misdelivered.has_error(), true );
+    }
+
+    // A bare ACK without options
+    {
+      TCPSegment seg;
+      seg.message.sender.seqno = Wrap32 { 7 };
+      seg.message.receiver.ackno = Wrap32 { 9 };
+      seg.message.receiver.window_size = 1;
+      seg.compute_checksum( pseudo_checksum( 20 ) );
+      const vector<Buffer> wire = serialize( seg );
+      TCPSegment parsed;
+      Parser p { wire };
+      parsed.parse( p, pseudo_checksum( 20 ) );
+      test_should_be( p.has_error(), false );
+      test_should_be( concatenate( wire ).size(), size_t { 20 } );
+      test_should_be( parsed.message.receiver.ackno.value(), Wrap32 { 9 } );
+      test_should_be( parsed.message.sender.TSval.has_value(), false );
+      test_should_be( parsed.message.receiver.TSecr.has_value(), false );
+      test_should_be( parsed.message.sender.payload.empty(), true );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
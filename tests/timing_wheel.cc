@@ -0,0 +1,95 @@
+#include "test_should_be.hh"
+#include "timing_wheel.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      TimingWheel wheel;
+      wheel.schedule( 10, 1 );
+      wheel.schedule( 5, 2 );
+      test_should_be( wheel.size(), size_t { 2 } );
+      test_should_be( wheel.advance( 4 ).size(), size_t { 0 } );
+      const vector<uint64_t> first = wheel.advance( 1 );
+      test_should_be( first.size(), size_t { 1 } );
+      test_should_be( first.at( 0 ), uint64_t { 2 } );
+      const vector<uint64_t> second = wheel.advance( 100 );
+      test_should_be( second.size(), size_t { 1 } );
+      test_should_be( second.at( 0 ), uint64_t { 1 } );
+      test_should_be( wheel.size(), size_t { 0 } );
+      test_should_be( wheel.now_ms(), uint64_t { 105 } );
+    }
+
+    // A cancelled timer never expires
+    {
+      TimingWheel wheel;
+      const TimingWheel::TimerId id = wheel.schedule( 10, 1 );
+      wheel.schedule( 20, 2 );
+      wheel.cancel( id );
+      wheel.cancel( id );
+      const vector<uint64_t> expired = wheel.advance( 30 );
+      test_should_be( expired.size(), size_t { 1 } );
+      test_should_be( expired.at( 0 ), uint64_t { 2 } );
+    }
+
+    // Timers on every level (and beyond the top one) expire exactly on time, in order
+    {
+      TimingWheel wheel;
+      wheel.advance( 12345 );
+      const vector<uint64_t> delays { 1, 63, 64, 65, 4095, 4096, 300000, 16777215, 16777216, 16777280 };
+      for ( const uint64_t delay : delays ) {
+        wheel.schedule( delay, delay );
+      }
+      uint64_t elapsed = 0;
+      for ( const uint64_t delay : delays ) {
+        test_should_be( wheel.advance( delay - 1 - elapsed ).size(), size_t { 0 } );
+        const vector<uint64_t> expired = wheel.advance( 1 );
+        test_should_be( expired.size(), size_t { 1 } );
+        test_should_be( expired.at( 0 ), delay );
+        elapsed = delay;
+      }
+    }
+
+    // Random timers, some cancelled, against a brute-force check, near and past the top level
+    for ( const auto& [max_delay, max_step] : { pair<uint64_t, uint64_t> { 200000, 5000 },
+                                                 pair<uint64_t, uint64_t> { 40000000, 100000 } } ) {
+      default_random_engine rd { 42 };
+      TimingWheel wheel;
+      vector<uint64_t> expiry;
+      vector<TimingWheel::TimerId> ids;
+      for ( uint64_t tag = 0; tag < 2000; tag++ ) {
+        expiry.push_back( uniform_int_distribution<uint64_t> { 1, max_delay }( rd ) );
+        ids.push_back( wheel.schedule( expiry.back(), tag ) );
+      }
+      for ( uint64_t tag = 0; tag < 2000; tag += 3 ) {
+        wheel.cancel( ids.at( tag ) );
+      }
+      uint64_t now = 0;
+      while ( wheel.size() > 0 ) {
+        const uint64_t step = uniform_int_distribution<uint64_t> { 1, max_step }( rd );
+        for ( const uint64_t tag : wheel.advance( step ) ) {
+          test_should_be( tag % 3 != 0, true );
+          test_should_be( expiry.at( tag ) > now && expiry.at( tag ) <= now + step, true );
+        }
+        now += step;
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
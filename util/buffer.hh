@@ -1,23 +1,91 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
+/*
+ * A reference-counted string, or a slice of one. Copies and slices share the storage, so a
+ * payload can travel from the ByteStream through the sender to the wire without being copied;
+ * asking for a mutable std::string (or releasing it) first gives a slice storage of its own.
+ */
 class Buffer
 {
   std::shared_ptr<std::string> buffer_;
+  size_t offset_ {};
+  size_t length_ { std::string::npos }; // npos: through the end of *buffer_, however long it grows
+
+  // Make this the only view of a string of its own, copying the slice out if need be
+  void own()
+  {
+    if ( offset_ != 0 || length_ != std::string::npos ) {
+      buffer_ = std::make_shared<std::string>( static_cast<std::string_view>( *this ) );
+      offset_ = 0;
+      length_ = std::string::npos;
+    }
+  }
 
 public:
   // NOLINTBEGIN(*-explicit-*)
 
   Buffer( std::string str = {} ) : buffer_( make_shared<std::string>( std::move( str ) ) ) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string&() { return *buffer_; }
+  operator std::string_view() const { return std::string_view { *buffer_ }.substr( offset_, length_ ); }
+  operator std::string&()
+  {
+    own();
+    return *buffer_;
+  }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string&& release() { return std::move( *buffer_ ); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  // Up to `n` bytes starting at `pos`, sharing this buffer's storage
+  Buffer slice( size_t pos, size_t n = std::string::npos ) const
+  {
+    Buffer piece = *this;
+    piece.offset_ += std::min( pos, size() );
+    piece.length_ = std::min( n, size() - std::min( pos, size() ) );
+    return piece;
+  }
+
+  // This slice and `next` as one slice, if `next` carries on where this one ends in the same storage
+  // (or either is empty)
+  std::optional<Buffer> joined( const Buffer& next ) const
+  {
+    if ( next.empty() ) {
+      return *this;
+    }
+    if ( empty() ) {
+      return next;
+    }
+    if ( buffer_ != next.buffer_ || offset_ + size() != next.offset_ ) {
+      return {};
+    }
+    Buffer whole = *this;
+    whole.length_ = size() + next.size();
+    return whole;
+  }
+
+  std::string&& release()
+  {
+    own();
+    return std::move( *buffer_ );
+  }
+  size_t size() const { return length_ == std::string::npos ? buffer_->size() - offset_ : length_; }
+  size_t length() const { return size(); }
+  bool empty() const { return size() == 0; }
+
+  // Append to a slice that runs to the end of its storage, in place if the storage has room (and
+  // so without moving the bytes other slices of it see); false, changing nothing, otherwise
+  bool append_in_place( std::string_view data )
+  {
+    if ( length_ == std::string::npos || offset_ + length_ != buffer_->size()
+         || buffer_->capacity() - buffer_->size() < data.size() ) {
+      return false;
+    }
+    buffer_->append( data );
+    length_ += data.size();
+    return true;
+  }
 };
@@ -13,6 +13,12 @@ struct IPv4Header
   static constexpr uint8_t DEFAULT_TTL = 128; // A reasonable default TTL value
   static constexpr uint8_t PROTO_TCP = 6;     // Protocol number for TCP
 
+  // ECN codepoints, the low two bits of the type of service (RFC 3168)
+  static constexpr uint8_t ECN_NOT_ECT = 0; // Sender doesn't support ECN
+  static constexpr uint8_t ECN_ECT1 = 1;    // ECN-capable transport
+  static constexpr uint8_t ECN_ECT0 = 2;    // ECN-capable transport
+  static constexpr uint8_t ECN_CE = 3;      // Congestion experienced, set by a router instead of dropping
+
   static constexpr uint64_t serialized_length() { return LENGTH; }
 
   /*
@@ -48,6 +54,10 @@ struct IPv4Header
   uint32_t src = 0;          // src address
   uint32_t dst = 0;          // dst address
 
+  // ECN codepoint
+  uint8_t ecn() const { return tos & 3; }
+  void set_ecn( uint8_t codepoint ) { tos = ( tos & ~3 ) | ( codepoint & 3 ); }
+
   // Length of the payload
   uint16_t payload_length() const;
 
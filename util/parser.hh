@@ -65,11 +65,7 @@ class Parser
       if ( empty() ) {
         return;
       }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
-      out.emplace_back( std::move( first_str ) );
+      out.push_back( buffer_.front().slice( skip_ ) );
       buffer_.pop_front();
       for ( auto&& x : buffer_ ) {
         out.emplace_back( std::move( x ) );
@@ -93,6 +89,9 @@ class Parser
 
     void append( Buffer str )
     {
+      if ( str.empty() ) {
+        return; // peek() expects every buffer to have something in it
+      }
       size_ += str.size();
       buffer_.push_back( std::move( str ) );
     }
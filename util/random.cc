@@ -1,15 +1,113 @@
 #include "random.hh"
 
-#include <algorithm>
-#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 
 using namespace std;
 
+namespace {
+
+uint64_t splitmix64( uint64_t& x )
+{
+  uint64_t z = ( x += 0x9e3779b97f4a7c15 );
+  z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9;
+  z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111eb;
+  return z ^ ( z >> 31 );
+}
+
+void sip_round( array<uint64_t, 4>& v )
+{
+  v[0] += v[1];
+  v[1] = rotl( v[1], 13 ) ^ v[0];
+  v[0] = rotl( v[0], 32 );
+  v[2] += v[3];
+  v[3] = rotl( v[3], 16 ) ^ v[2];
+  v[0] += v[3];
+  v[3] = rotl( v[3], 21 ) ^ v[0];
+  v[2] += v[1];
+  v[1] = rotl( v[1], 17 ) ^ v[2];
+  v[2] = rotl( v[2], 32 );
+}
+
+// SipHash-2-4 of a 12-byte message, given as one little-endian word and four trailing bytes
+uint64_t siphash24( const array<uint64_t, 2>& key, uint64_t m0, uint32_t tail )
+{
+  array<uint64_t, 4> v { key[0] ^ 0x736f6d6570736575,
+                         key[1] ^ 0x646f72616e646f6d,
+                         key[0] ^ 0x6c7967656e657261,
+                         key[1] ^ 0x7465646279746573 };
+  const uint64_t m1 = uint64_t { 12 } << 56 | tail;
+  for ( const uint64_t m : { m0, m1 } ) {
+    v[3] ^= m;
+    sip_round( v );
+    sip_round( v );
+    v[0] ^= m;
+  }
+  v[2] ^= 0xff;
+  for ( int i = 0; i < 4; i++ ) {
+    sip_round( v );
+  }
+  return v[0] ^ v[1] ^ v[2] ^ v[3];
+}
+
+} // namespace
+
+FastRandom::FastRandom( uint64_t seed )
+{
+  for ( auto& word : s_ ) {
+    word = splitmix64( seed );
+  }
+}
+
+FastRandom::result_type FastRandom::operator()()
+{
+  const uint64_t result = rotl( s_[1] * 5, 7 ) * 9;
+  const uint64_t t = s_[1] << 17;
+  s_[2] ^= s_[0];
+  s_[3] ^= s_[1];
+  s_[1] ^= s_[2];
+  s_[0] ^= s_[3];
+  s_[2] ^= t;
+  s_[3] = rotl( s_[3], 45 );
+  return result;
+}
+
+uint64_t process_seed()
+{
+  static const uint64_t seed = [] {
+    random_device rd;
+    return uint64_t { rd() } << 32 | rd();
+  }();
+  return seed;
+}
+
+FastRandom& thread_random()
+{
+  // Each thread gets its own stream: the process seed, stirred with a thread count
+  static atomic<uint64_t> threads {};
+  thread_local FastRandom rng { [] {
+    uint64_t x = process_seed() + threads.fetch_add( 1 );
+    return splitmix64( x );
+  }() };
+  return rng;
+}
+
 default_random_engine get_random_engine()
 {
-  auto rd = random_device();
-  array<uint32_t, 1024> seed_data {};
-  generate( seed_data.begin(), seed_data.end(), [&] { return rd(); } );
-  seed_seq seed( seed_data.begin(), seed_data.end() );
-  return default_random_engine( seed );
+  return default_random_engine( static_cast<default_random_engine::result_type>( thread_random()() ) );
+}
+
+uint32_t generate_isn( uint32_t local_address, uint16_t local_port, uint32_t remote_address, uint16_t remote_port )
+{
+  // Drawn separately from process_seed(), so that nothing learned from FastRandom output reveals it
+  static const array<uint64_t, 2> secret = [] {
+    random_device rd;
+    return array<uint64_t, 2> { uint64_t { rd() } << 32 | rd(), uint64_t { rd() } << 32 | rd() };
+  }();
+  const auto now = chrono::steady_clock::now().time_since_epoch();
+  const auto ticks = static_cast<uint32_t>( chrono::duration_cast<chrono::microseconds>( now ).count() / 4 );
+  const uint64_t addresses = uint64_t { local_address } << 32 | remote_address;
+  const uint32_t ports = uint32_t { local_port } << 16 | remote_port;
+  return ticks + static_cast<uint32_t>( siphash24( secret, addresses, ports ) );
 }
@@ -1,5 +1,42 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <random>
 
+/*
+ * xoshiro256** (Blackman and Vigna): a fast generator with 256 bits of state, for simulations,
+ * tests and anything else that needs plenty of unpredictable-looking numbers cheaply. It is
+ * not cryptographically secure. Satisfies UniformRandomBitGenerator, so it works with the
+ * <random> distributions.
+ */
+class FastRandom
+{
+  std::array<uint64_t, 4> s_ {};
+
+public:
+  using result_type = uint64_t;
+
+  explicit FastRandom( uint64_t seed ); // The state is expanded from the seed with SplitMix64
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return UINT64_MAX; }
+  result_type operator()();
+};
+
+// A seed drawn from std::random_device once per process
+uint64_t process_seed();
+
+// This thread's FastRandom, seeded from process_seed() on first use
+FastRandom& thread_random();
+
+// A standard engine seeded from thread_random(), without touching std::random_device
 std::default_random_engine get_random_engine();
+
+/*
+ * An initial sequence number as in RFC 6528: ISN = M + F(4-tuple, secret), where M is a clock that
+ * ticks every 4 microseconds and F is SipHash-2-4 keyed with a secret chosen once per process.
+ * Successive connections with the same addresses and ports get ISNs that advance with the clock,
+ * while an off-path attacker can't predict the ISN of anyone else's connection.
+ */
+uint32_t generate_isn( uint32_t local_address, uint16_t local_port, uint32_t remote_address, uint16_t remote_port );
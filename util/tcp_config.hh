@@ -6,17 +6,62 @@
 #include <cstdint>
 #include <optional>
 
+//! Congestion control algorithms the TCPSender can run
+enum class CongestionControlAlgorithm
+{
+  NONE,  //!< Limited only by the receiver's window
+  RENO,  //!< Reno/NewReno (RFC 5681, RFC 6582)
+  CUBIC, //!< CUBIC (RFC 9438)
+  BBR,   //!< Model-based BBR (draft-cardwell-iccrg-bbr-congestion-control)
+  DCTCP, //!< Data Center TCP (RFC 8257): ECN cuts scaled by the fraction of marked bytes
+};
+
+//! What the TCPSender does with a write too small to fill a segment
+enum class Coalescing
+{
+  NODELAY, //!< Send it right away
+  NAGLE,   //!< Hold it while earlier data is unacknowledged (RFC 896)
+  CORK,    //!< Hold it until a full segment accumulates or TCPSender::flush()
+};
+
+//! A connection's addresses and ports (IPv4, numeric)
+struct FourTuple
+{
+  uint32_t local_address {};
+  uint16_t local_port {};
+  uint32_t remote_address {};
+  uint16_t remote_port {};
+};
+
 //! Config for TCP sender and receiver
 class TCPConfig
 {
 public:
-  static constexpr size_t DEFAULT_CAPACITY = 64000; //!< Default capacity
-  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
-  static constexpr uint16_t TIMEOUT_DFLT = 1000;    //!< Default re-transmit timeout is 1 second
-  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;  //!< Maximum re-transmit attempts before giving up
+  static constexpr size_t DEFAULT_CAPACITY = 64000;       //!< Default capacity
+  static constexpr size_t MAX_PAYLOAD_SIZE = 1000;        //!< Conservative max payload size for real Internet
+  static constexpr uint16_t TIMEOUT_DFLT = 1000;          //!< Default re-transmit timeout is 1 second
+  static constexpr uint16_t MIN_TIMEOUT_DFLT = 200;       //!< Default lower bound on a computed timeout
+  static constexpr uint16_t MAX_TIMEOUT_DFLT = 60000;     //!< Default upper bound on an adaptive timeout
+  static constexpr unsigned MAX_RETX_ATTEMPTS = 8;        //!< Maximum re-transmit attempts before giving up
+  static constexpr size_t MAX_SACK_BLOCKS = 3;            //!< SACK blocks that fit in the options next to timestamps
+  static constexpr size_t MAX_SUPER_SEGMENT_SIZE = 64000; //!< Largest payload of a super segment
 
-  uint16_t rt_timeout = TIMEOUT_DFLT;      //!< Initial value of the retransmission timeout, in milliseconds
-  size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
-  size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+  uint16_t rt_timeout = TIMEOUT_DFLT;         //!< Initial value of the retransmission timeout, in milliseconds
+  bool adaptive_rt_timeout = false;           //!< Compute the timeout from RTT samples (RFC 6298)
+  uint16_t rt_timeout_min = MIN_TIMEOUT_DFLT; //!< Lower bound on the computed timeout, in milliseconds
+  uint16_t rt_timeout_max = MAX_TIMEOUT_DFLT; //!< Upper bound on the adaptive timeout, backoff included
+  size_t recv_capacity = DEFAULT_CAPACITY;    //!< Receive capacity, in bytes
+  size_t send_capacity = DEFAULT_CAPACITY;    //!< Sender capacity, in bytes
+  uint16_t mss = MAX_PAYLOAD_SIZE;            //!< Largest payload to send, and to accept (advertised as the MSS)
+  bool super_segments = false;                //!< Send many-MSS segments, for TCPSenderMessage::split() to cut up
+  bool mtu_probing = false;                   //!< Start at MAX_PAYLOAD_SIZE and probe up to `mss` (RFC 4821)
   std::optional<Wrap32> fixed_isn {};
+  FourTuple four_tuple {}; //!< Keys the ISN when there's no fixed_isn (RFC 6528)
+  CongestionControlAlgorithm congestion_control = CongestionControlAlgorithm::NONE; //!< Congestion control
+  bool pacing = false;   //!< Space transmissions out at TCPSender::pacing_rate() instead of sending in bursts
+  bool rack_tlp = false; //!< Time-based loss detection and tail loss probes (RACK-TLP, RFC 8985)
+  bool frto = false;     //!< Detect spurious timeouts and undo their response (F-RTO and Eifel, RFC 4015)
+  bool ecn = false;      //!< Send ECN-capable segments and treat ECE as congestion (RFC 3168); DCTCP implies it
+  std::optional<uint64_t> notsent_lowat {}; //!< Writable only below this many unsent bytes (TCP_NOTSENT_LOWAT)
+  Coalescing coalescing = Coalescing::NODELAY; //!< Whether small writes wait to be coalesced into full segments
 };
@@ -0,0 +1,38 @@
+#include "tcp_over_ip.hh"
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+using namespace std;
+
+InternetDatagram wrap_tcp_in_ip( TCPSegment segment, uint32_t src, uint32_t dst )
+{
+  InternetDatagram datagram;
+  datagram.header.src = src;
+  datagram.header.dst = dst;
+  datagram.header.proto = IPv4Header::PROTO_TCP;
+  datagram.header.set_ecn( segment.message.sender.ECN );
+  const size_t segment_length = segment.header().size() + segment.message.sender.payload.size();
+  datagram.header.len = static_cast<uint16_t>( datagram.header.hlen * 4 + segment_length );
+  datagram.header.compute_checksum();
+
+  segment.compute_checksum( datagram.header.pseudo_checksum() );
+  datagram.payload = serialize( segment );
+  return datagram;
+}
+
+optional<TCPSegment> unwrap_tcp_in_ip( const InternetDatagram& datagram )
+{
+  if ( datagram.header.proto != IPv4Header::PROTO_TCP ) {
+    return {};
+  }
+  TCPSegment segment;
+  Parser parser { datagram.payload };
+  segment.parse( parser, datagram.header.pseudo_checksum() );
+  if ( parser.has_error() ) {
+    return {};
+  }
+  segment.message.sender.ECN = datagram.header.ecn();
+  return segment;
+}
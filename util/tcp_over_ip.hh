@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ipv4_datagram.hh"
+#include "tcp_segment.hh"
+
+#include <cstdint>
+#include <optional>
+
+/*
+ * TCP carried in IPv4 datagrams. The segment's ECN codepoint (`message.sender.ECN`) travels in the
+ * IP header rather than the TCP one, so it is copied into the datagram here and back out of it,
+ * CE marks made along the way included.
+ */
+
+// Wrap a segment in a datagram from `src` to `dst`, with the lengths and both checksums filled in
+InternetDatagram wrap_tcp_in_ip( TCPSegment segment, uint32_t src, uint32_t dst );
+
+// The segment a datagram carries, or nothing if it isn't TCP or doesn't parse
+std::optional<TCPSegment> unwrap_tcp_in_ip( const InternetDatagram& datagram );
@@ -2,12 +2,14 @@
 
 #include "wrapping_integers.hh"
 
+#include <cstdint>
 #include <optional>
+#include <vector>
 
 /*
  * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
  *
- * It contains two fields:
+ * It contains six fields:
  *
  * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
  *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
@@ -15,10 +17,33 @@
  * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
  *    to receive, starting from the ackno if present. The maximum value is 65,535 (UINT16_MAX from
  *    the <cstdint> header).
+ *
+ * 3) The timestamp echo reply (TSecr): the TSval of the most recent segment that advanced the ackno.
+ *    The sender subtracts it from its own clock to take an RTT sample on every ACK.
+ *
+ * 4) Selective acknowledgment (SACK) blocks, RFC 2018: up to TCPConfig::MAX_SACK_BLOCKS ranges of
+ *    sequence numbers past the ackno that the receiver already holds. The first block contains the
+ *    most recently received segment.
+ *
+ * 5) The maximum segment size (MSS): the largest payload the receiver accepts in one segment. It
+ *    travels in the MSS option of the SYN; the peer's sender never sends more than this.
+ *
+ * 6) The ECE flag (RFC 3168): segments arrived marked CE, so the sender should slow down as if
+ *    they had been lost.
  */
 
+struct SACKBlock
+{
+  Wrap32 begin; // First sequence number of the block
+  Wrap32 end;   // One past the last
+};
+
 struct TCPReceiverMessage
 {
   std::optional<Wrap32> ackno {};
   uint16_t window_size {};
+  std::optional<uint32_t> TSecr {};
+  std::vector<SACKBlock> SACK {};
+  std::optional<uint16_t> MSS {};
+  bool ECE {};
 };
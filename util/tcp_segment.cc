@@ -0,0 +1,219 @@
+#include "tcp_segment.hh"
+#include "checksum.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+constexpr uint8_t FLAG_CWR = 0x80;
+constexpr uint8_t FLAG_ECE = 0x40;
+constexpr uint8_t FLAG_ACK = 0x10;
+constexpr uint8_t FLAG_SYN = 0x02;
+constexpr uint8_t FLAG_FIN = 0x01;
+
+constexpr uint8_t OPTION_END = 0;
+constexpr uint8_t OPTION_NOP = 1;
+constexpr uint8_t OPTION_MSS = 2;
+constexpr uint8_t OPTION_SACK = 5;
+constexpr uint8_t OPTION_TIMESTAMPS = 8;
+
+constexpr size_t MSS_OPTION_LENGTH = 4;
+constexpr size_t TIMESTAMPS_OPTION_LENGTH = 12; // Two NOPs first, to keep the values aligned
+constexpr size_t SACK_OPTION_LENGTH = 4;        // Two NOPs, kind and length, then 8 bytes per block
+
+// The raw sequence number, which only the wire needs to see
+class WireWrap32 : public Wrap32
+{
+public:
+  explicit WireWrap32( Wrap32 w ) : Wrap32( w ) {}
+  uint32_t raw() const { return raw_value_; }
+};
+
+uint32_t raw( Wrap32 w )
+{
+  return WireWrap32 { w }.raw();
+}
+
+uint32_t big_endian( string_view in, size_t pos, size_t len )
+{
+  uint32_t value = 0;
+  for ( size_t i = 0; i < len; i++ ) {
+    value = value << 8 | static_cast<uint8_t>( in[pos + i] );
+  }
+  return value;
+}
+
+} // namespace
+
+string TCPSegment::header() const
+{
+  const TCPSenderMessage& sender = message.sender;
+  const TCPReceiverMessage& receiver = message.receiver;
+
+  const size_t mss_length = sender.SYN && receiver.MSS.has_value() ? MSS_OPTION_LENGTH : 0;
+  const bool timestamps = sender.TSval.has_value() || receiver.TSecr.has_value();
+  const size_t timestamps_length = timestamps ? TIMESTAMPS_OPTION_LENGTH : 0;
+  size_t sack_blocks = 0;
+  if ( receiver.ackno.has_value() ) {
+    const size_t room = MAX_OPTIONS_LENGTH - mss_length - timestamps_length;
+    sack_blocks = room < SACK_OPTION_LENGTH ? 0 : min( receiver.SACK.size(), ( room - SACK_OPTION_LENGTH ) / 8 );
+  }
+  const size_t sack_length = sack_blocks > 0 ? SACK_OPTION_LENGTH + 8 * sack_blocks : 0;
+  const size_t length = HEADER_LENGTH + mss_length + timestamps_length + sack_length;
+
+  string buffer;
+  buffer.reserve( length );
+  Serializer s { std::move( buffer ) };
+  s.integer( sport );
+  s.integer( dport );
+  s.integer( raw( sender.seqno ) );
+  s.integer( receiver.ackno.has_value() ? raw( receiver.ackno.value() ) : uint32_t { 0 } );
+  s.integer( static_cast<uint8_t>( length / 4 << 4 ) );
+  const uint8_t flags = ( sender.CWR ? FLAG_CWR : 0 ) | ( receiver.ECE ? FLAG_ECE : 0 )
+                        | ( receiver.ackno.has_value() ? FLAG_ACK : 0 ) | ( sender.SYN ? FLAG_SYN : 0 )
+                        | ( sender.FIN ? FLAG_FIN : 0 );
+  s.integer( flags );
+  s.integer( receiver.window_size );
+  s.integer( cksum );
+  s.integer( uint16_t { 0 } ); // urgent pointer
+
+  if ( mss_length > 0 ) {
+    s.integer( OPTION_MSS );
+    s.integer( static_cast<uint8_t>( MSS_OPTION_LENGTH ) );
+    s.integer( receiver.MSS.value() );
+  }
+  if ( timestamps ) {
+    s.integer( OPTION_NOP );
+    s.integer( OPTION_NOP );
+    s.integer( OPTION_TIMESTAMPS );
+    s.integer( static_cast<uint8_t>( TIMESTAMPS_OPTION_LENGTH - 2 ) );
+    s.integer( sender.TSval.value_or( 0 ) );
+    s.integer( receiver.TSecr.value_or( 0 ) );
+  }
+  if ( sack_blocks > 0 ) {
+    s.integer( OPTION_NOP );
+    s.integer( OPTION_NOP );
+    s.integer( OPTION_SACK );
+    s.integer( static_cast<uint8_t>( sack_length - 2 ) );
+    for ( size_t i = 0; i < sack_blocks; i++ ) {
+      s.integer( raw( receiver.SACK[i].begin ) );
+      s.integer( raw( receiver.SACK[i].end ) );
+    }
+  }
+
+  return s.output().front().release();
+}
+
+void TCPSegment::serialize( Serializer& serializer ) const
+{
+  serializer.buffer( header() );
+  if ( !message.sender.payload.empty() ) {
+    serializer.buffer( message.sender.payload );
+  }
+}
+
+void TCPSegment::compute_checksum( uint32_t datagram_layer_pseudo_checksum )
+{
+  cksum = 0;
+  // The header is an even length, so the payload is summed from an even offset, a word at a time
+  InternetChecksum check { datagram_layer_pseudo_checksum };
+  check.add( header() );
+  check.add( message.sender.payload );
+  cksum = check.value();
+}
+
+void TCPSegment::parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum )
+{
+  // Verify the checksum over the segment's buffers as they are, before taking anything apart
+  {
+    auto input = parser.input();
+    vector<Buffer> buffers;
+    input.dump_all( buffers );
+    InternetChecksum check { datagram_layer_pseudo_checksum };
+    check.add( buffers );
+    if ( check.value() != 0 ) {
+      parser.set_error();
+      return;
+    }
+  }
+
+  uint32_t seqno {};
+  uint32_t ackno {};
+  uint8_t data_offset {};
+  uint8_t flags {};
+  uint16_t window_size {};
+  uint16_t urgent {};
+  parser.integer( sport );
+  parser.integer( dport );
+  parser.integer( seqno );
+  parser.integer( ackno );
+  parser.integer( data_offset );
+  parser.integer( flags );
+  parser.integer( window_size );
+  parser.integer( cksum );
+  parser.integer( urgent );
+
+  const size_t length = static_cast<size_t>( data_offset >> 4 ) * 4;
+  if ( parser.has_error() || length < HEADER_LENGTH ) {
+    parser.set_error();
+    return;
+  }
+  string options( length - HEADER_LENGTH, 0 );
+  parser.string( options );
+
+  TCPSenderMessage& sender = message.sender;
+  TCPReceiverMessage& receiver = message.receiver;
+  sender = {};
+  sender.seqno = Wrap32 { seqno };
+  sender.SYN = ( flags & FLAG_SYN ) != 0;
+  sender.FIN = ( flags & FLAG_FIN ) != 0;
+  sender.CWR = ( flags & FLAG_CWR ) != 0;
+  receiver = {};
+  if ( flags & FLAG_ACK ) {
+    receiver.ackno = Wrap32 { ackno };
+  }
+  receiver.window_size = window_size;
+  receiver.ECE = ( flags & FLAG_ECE ) != 0;
+
+  for ( size_t i = 0; i < options.size(); ) {
+    const auto kind = static_cast<uint8_t>( options[i] );
+    if ( kind == OPTION_END ) {
+      break;
+    }
+    if ( kind == OPTION_NOP ) {
+      i++;
+      continue;
+    }
+    const size_t len = i + 1 < options.size() ? static_cast<uint8_t>( options[i + 1] ) : 0;
+    if ( len < 2 || i + len > options.size() ) {
+      parser.set_error();
+      return;
+    }
+    const string_view body = string_view { options }.substr( i + 2, len - 2 );
+    if ( kind == OPTION_MSS && body.size() == 2 ) {
+      receiver.MSS = static_cast<uint16_t>( big_endian( body, 0, 2 ) );
+    } else if ( kind == OPTION_TIMESTAMPS && body.size() == 8 ) {
+      sender.TSval = big_endian( body, 0, 4 );
+      if ( receiver.ackno.has_value() ) {
+        receiver.TSecr = big_endian( body, 4, 4 );
+      }
+    } else if ( kind == OPTION_SACK && body.size() % 8 == 0 ) {
+      for ( size_t block = 0; block < body.size(); block += 8 ) {
+        receiver.SACK.push_back(
+          { Wrap32 { big_endian( body, block, 4 ) }, Wrap32 { big_endian( body, block + 4, 4 ) } } );
+      }
+    }
+    i += len;
+  }
+
+  parser.all_remaining( sender.payload );
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "parser.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// What one peer sends the other: its sender's segment, with its receiver's acknowledgment riding along
+struct TCPMessage
+{
+  TCPSenderMessage sender {};
+  TCPReceiverMessage receiver {};
+};
+
+// A TCP segment on the wire (RFC 9293), carrying a TCPMessage
+struct TCPSegment
+{
+  static constexpr size_t HEADER_LENGTH = 20;      // TCP header length, not including options
+  static constexpr size_t MAX_OPTIONS_LENGTH = 40; // Data offset is four bits of 32-bit words
+
+  /*
+   *   0                   1                   2                   3
+   *   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |          Source Port          |       Destination Port        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                        Sequence Number                        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Acknowledgment Number                      |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |  Data |       |C|E|U|A|P|R|S|F|                               |
+   *  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+   *  |       |       |R|E|G|K|H|T|N|N|                               |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |           Checksum            |         Urgent Pointer        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                           [Options]                           |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                             Data                              |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *
+   * The options carried are MSS (on SYN segments), timestamps (RFC 7323) and SACK (RFC 2018).
+   * The ECN codepoint belongs to the IP header, so wrap_tcp_in_ip() and unwrap_tcp_in_ip()
+   * (tcp_over_ip.hh) copy it in and out of `message.sender.ECN`.
+   */
+
+  uint16_t sport = 0; // source port
+  uint16_t dport = 0; // destination port
+  TCPMessage message {};
+  uint16_t cksum = 0; // checksum field
+
+  // Parse a segment, rejecting it if the checksum (including the pseudo-header's part) is wrong
+  void parse( Parser& parser, uint32_t datagram_layer_pseudo_checksum );
+
+  // Serialize the header (with the checksum as it stands) and, without copying, the payload
+  void serialize( Serializer& serializer ) const;
+
+  // Set the checksum to the correct value, given the pseudo-header's part (IPv4Header::pseudo_checksum())
+  void compute_checksum( uint32_t datagram_layer_pseudo_checksum );
+
+  // The header and options, serialized contiguously
+  std::string header() const;
+};
@@ -3,12 +3,15 @@
 #include "buffer.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 /*
  * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
  *
- * It contains four fields:
+ * It contains seven fields:
  *
  * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
  *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
@@ -19,6 +22,16 @@
  * 3) The payload: a substring (possibly empty) of the byte stream.
  *
  * 4) The FIN flag. If set, it means the payload represents the ending of the byte stream.
+ *
+ * 5) The timestamp value (TSval) of the sender's clock when the segment was sent, as in the TCP timestamps
+ *    option (RFC 7323). The receiver echoes it back and uses it to reject old duplicates (PAWS).
+ *
+ * 6) The CWR flag (RFC 3168): the sender has reduced its window in response to ECE, so the receiver
+ *    can stop echoing the congestion it saw.
+ *
+ * 7) The ECN codepoint of the IP datagram carrying the segment (IPv4Header::ECN_*). The sender sets
+ *    ECT on new data; a router may turn that into CE instead of dropping the datagram, and the
+ *    receiver echoes CE back to the sender as ECE.
  */
 
 struct TCPSenderMessage
@@ -27,7 +40,49 @@ struct TCPSenderMessage
   bool SYN { false };
   Buffer payload {};
   bool FIN { false };
+  std::optional<uint32_t> TSval {};
+  bool CWR { false };
+  uint8_t ECN {};
 
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
+
+  // Cut a super segment into segments of at most `mss` payload bytes, at the last moment before
+  // they go on the wire. SYN stays with the first piece, FIN with the last. The pieces' payloads
+  // are slices of this one's, so nothing is copied.
+  std::vector<TCPSenderMessage> split( size_t mss ) const
+  {
+    if ( payload.size() <= mss ) {
+      return { *this };
+    }
+    std::vector<TCPSenderMessage> pieces;
+    pieces.reserve( ( payload.size() + mss - 1 ) / mss );
+    for ( size_t offset = 0; offset < payload.size(); offset += mss ) {
+      const bool first = offset == 0;
+      const bool last = offset + mss >= payload.size();
+      pieces.push_back( { first ? seqno : seqno + static_cast<uint32_t>( SYN + offset ),
+                          SYN && first,
+                          payload.slice( offset, mss ),
+                          FIN && last,
+                          TSval,
+                          CWR && first,
+                          ECN } );
+    }
+    return pieces;
+  }
+
+  // Drop the first `n` sequence numbers, which the receiver has acknowledged, so that a
+  // retransmission carries only the remainder. `n` must be less than sequence_length().
+  void remove_prefix( size_t n )
+  {
+    if ( SYN && n > 0 ) {
+      SYN = false;
+      seqno = seqno + 1;
+      n--;
+    }
+    if ( n > 0 ) {
+      payload = payload.slice( n );
+      seqno = seqno + static_cast<uint32_t>( n );
+    }
+  }
 };
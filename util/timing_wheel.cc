@@ -0,0 +1,110 @@
+#include "timing_wheel.hh"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+TimingWheel::TimerId TimingWheel::schedule( uint64_t delay_ms, uint64_t tag )
+{
+  const TimerId id = next_id_++;
+  const uint64_t expiry_ms = now_ms_ + max<uint64_t>( delay_ms, 1 );
+  timers_.emplace( id, Timer { expiry_ms, tag } );
+  place( id, expiry_ms );
+  return id;
+}
+
+void TimingWheel::place( TimerId id, uint64_t expiry_ms )
+{
+  // The lowest level whose slot span contains both now and the expiry
+  uint64_t level = 0;
+  while ( level + 1 < LEVELS && ( ( expiry_ms ^ now_ms_ ) >> ( SLOT_BITS * ( level + 1 ) ) ) != 0 ) {
+    level++;
+  }
+  const uint64_t slot = ( expiry_ms >> ( SLOT_BITS * level ) ) % SLOTS;
+  slots_.at( level ).at( slot ).push_back( id );
+  occupied_.at( level ) |= uint64_t { 1 } << slot;
+  queued_++;
+}
+
+// Empty the level's slot for the current time
+vector<TimingWheel::TimerId> TimingWheel::take( uint64_t level )
+{
+  const uint64_t slot = ( now_ms_ >> ( SLOT_BITS * level ) ) % SLOTS;
+  vector<TimerId> ids = std::exchange( slots_.at( level ).at( slot ), {} );
+  occupied_.at( level ) &= ~( uint64_t { 1 } << slot );
+  queued_ -= ids.size();
+  return ids;
+}
+
+void TimingWheel::cascade( uint64_t level )
+{
+  for ( const TimerId id : take( level ) ) {
+    if ( const auto it = timers_.find( id ); it != timers_.end() ) {
+      place( id, it->second.expiry_ms );
+    }
+  }
+}
+
+// The first time after now at which an occupied slot comes round: a level-0 slot expires, a
+// higher one cascades
+uint64_t TimingWheel::next_visit_ms() const
+{
+  uint64_t next = numeric_limits<uint64_t>::max();
+  for ( uint64_t level = 0; level < LEVELS; level++ ) {
+    const uint64_t occupied = occupied_.at( level );
+    if ( occupied == 0 ) {
+      continue;
+    }
+    const uint64_t shift = SLOT_BITS * level;
+    const uint64_t current = ( now_ms_ >> shift ) % SLOTS;
+    const uint64_t rotation_start = now_ms_ >> ( shift + SLOT_BITS ) << ( shift + SLOT_BITS );
+    const uint64_t later = current + 1 == SLOTS ? 0 : occupied & ( ~uint64_t { 0 } << ( current + 1 ) );
+    // Past the last slot means the next rotation: only the top level holds timers that far away
+    const uint64_t slot = later != 0 ? static_cast<uint64_t>( countr_zero( later ) )
+                                     : SLOTS + static_cast<uint64_t>( countr_zero( occupied ) );
+    next = min( next, rotation_start + ( slot << shift ) );
+  }
+  return next;
+}
+
+vector<uint64_t> TimingWheel::advance( uint64_t ms )
+{
+  vector<uint64_t> expired;
+  if ( timers_.empty() ) {
+    // Nothing can expire: jump straight there, forgetting any cancelled timers
+    if ( queued_ > 0 ) {
+      for ( auto& level : slots_ ) {
+        for ( auto& slot : level ) {
+          slot.clear();
+        }
+      }
+      occupied_ = {};
+      queued_ = 0;
+    }
+    now_ms_ += ms;
+    return expired;
+  }
+
+  const uint64_t target_ms = now_ms_ + ms;
+  // Every millisecond between one occupied slot and the next would find nothing to do: skip them
+  for ( uint64_t visit = next_visit_ms(); visit <= target_ms; visit = next_visit_ms() ) {
+    now_ms_ = visit;
+    // When a level wraps around, the next slot of the level above is due to be spread out below
+    for ( uint64_t level = LEVELS - 1; level > 0; level-- ) {
+      if ( now_ms_ % ( uint64_t { 1 } << ( SLOT_BITS * level ) ) == 0 ) {
+        cascade( level );
+      }
+    }
+    for ( const TimerId id : take( 0 ) ) {
+      if ( const auto it = timers_.find( id ); it != timers_.end() ) {
+        expired.push_back( it->second.tag );
+        timers_.erase( it );
+      }
+    }
+  }
+  now_ms_ = target_ms;
+  return expired;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * A hierarchical timing wheel (Varghese and Lauck): timers are hashed into slots by expiry time,
+ * so schedule() and cancel() are O(1). Each level keeps a bitmap of its occupied slots, and
+ * advancing the clock jumps from one occupied slot to the next, so it costs as much as the timers
+ * it touches, however far the clock moves.
+ *
+ * Four levels of 64 slots at 1 ms resolution cover 2^24 ms (about 4.6 hours) exactly. A timer
+ * lands on the level where its expiry first differs from the current time, and moves down a level
+ * each time the level below wraps around. Timers further out than the top level wait in its slots
+ * and are rehashed as they come round.
+ *
+ * Each timer carries a caller-chosen tag (an IP address, a connection number), which advance()
+ * hands back on expiry. Cancelled timers are dropped lazily, when their slot is next visited.
+ */
+class TimingWheel
+{
+public:
+  using TimerId = uint64_t;
+
+  // Arm a timer to expire `delay_ms` milliseconds from now (at least 1)
+  TimerId schedule( uint64_t delay_ms, uint64_t tag );
+
+  // Disarm a timer; harmless if it already expired or was cancelled
+  void cancel( TimerId id ) { timers_.erase( id ); }
+
+  // Move the clock forward, returning the tags of the timers that expired, earliest first
+  std::vector<uint64_t> advance( uint64_t ms );
+
+  uint64_t now_ms() const { return now_ms_; }
+  size_t size() const { return timers_.size(); } // How many timers are armed?
+
+private:
+  static constexpr uint64_t SLOT_BITS = 6;
+  static constexpr uint64_t SLOTS = 1 << SLOT_BITS;
+  static constexpr uint64_t LEVELS = 4;
+
+  struct Timer
+  {
+    uint64_t expiry_ms;
+    uint64_t tag;
+  };
+
+  std::array<std::array<std::vector<TimerId>, SLOTS>, LEVELS> slots_ {};
+  std::array<uint64_t, LEVELS> occupied_ {}; // Bit i set: slots_[level][i] is non-empty
+  std::unordered_map<TimerId, Timer> timers_ {};
+  uint64_t queued_ {}; // Ids in slots_, including cancelled ones not yet dropped
+  uint64_t now_ms_ {};
+  TimerId next_id_ {};
+
+  void place( TimerId id, uint64_t expiry_ms );
+  std::vector<TimerId> take( uint64_t level );
+  void cascade( uint64_t level );
+  uint64_t next_visit_ms() const;
+};